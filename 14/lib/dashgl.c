@@ -31,6 +31,18 @@
 /** Vector3 Utils                                                            **/
 /******************************************************************************/
 
+void vec3_add(vec3 a, vec3 b, vec3 v) {
+	
+	vec3 tmp;
+	tmp[0] = a[0] + b[0];
+	tmp[1] = a[1] + b[1];
+	tmp[2] = a[2] + b[2];
+	
+	v[0] = tmp[0];
+	v[1] = tmp[1];
+	v[2] = tmp[2];
+}
+
 void vec3_subtract(vec3 a, vec3 b, vec3 v) {
 	
 	vec3 tmp;
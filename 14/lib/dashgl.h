@@ -65,6 +65,7 @@
 	/** Vector3 Utilities                                                **/	
 	/**********************************************************************/
 
+	void vec3_add(vec3 a, vec3 b, vec3 v);
 	void vec3_subtract(vec3 a, vec3 b, vec3 v);
 	void vec3_cross_multiply(vec3 a, vec3 b, vec3 v);
 	void vec3_normalize(vec3 a, vec3 v);
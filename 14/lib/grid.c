@@ -0,0 +1,181 @@
+/*
+    This file is part of Dash Graphics Library
+    Copyright 2017 Benjamin Collins
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy of this
+    software and associated documentation files (the "Software"), to deal in the Software
+    without restriction, including without limitation the rights to use, copy, modify, merge,
+    publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+    to whom the Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all copies or
+    substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+    INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+    PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+    FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+    OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+*/
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "grid.h"
+
+/******************************************************************************/
+/** Uniform Grid                                                             **/
+/******************************************************************************/
+
+static int dash_grid_clamp(int value, int max) {
+
+	if(value < 0) {
+		return 0;
+	}
+
+	return value < max ? value : max - 1;
+
+}
+
+static int dash_grid_col(DashGrid *grid, float x) {
+
+	return dash_grid_clamp((int)floorf(x / grid->cell_size), grid->cols);
+
+}
+
+static int dash_grid_row(DashGrid *grid, float y) {
+
+	return dash_grid_clamp((int)floorf(y / grid->cell_size), grid->rows);
+
+}
+
+int dash_grid_init(DashGrid *grid, float width, float height, float cell_size, int capacity) {
+
+	int num_cells;
+
+	memset(grid, 0, sizeof(DashGrid));
+
+	grid->cell_size = cell_size;
+	grid->cols = (int)ceilf(width / cell_size);
+	grid->rows = (int)ceilf(height / cell_size);
+	num_cells = grid->cols * grid->rows;
+
+	// One extra start so the last cell's run ends like any other
+
+	grid->cell_start = (int*)calloc(num_cells + 1, sizeof(int));
+	grid->cell_of = (int*)malloc(capacity * sizeof(int));
+	grid->ids = (int*)malloc(capacity * sizeof(int));
+	grid->sorted = (int*)malloc(capacity * sizeof(int));
+
+	if(!grid->cell_start || !grid->cell_of || !grid->ids || !grid->sorted) {
+		dash_grid_free(grid);
+		return 0;
+	}
+
+	grid->capacity = capacity;
+	return 1;
+
+}
+
+void dash_grid_clear(DashGrid *grid) {
+
+	memset(grid->cell_start, 0, (grid->cols * grid->rows + 1) * sizeof(int));
+	grid->count = 0;
+
+}
+
+int dash_grid_insert(DashGrid *grid, int id, float x, float y) {
+
+	int cell;
+
+	if(grid->count == grid->capacity) {
+		return 0;
+	}
+
+	// Counted here, placed by the sort
+
+	cell = dash_grid_row(grid, y) * grid->cols + dash_grid_col(grid, x);
+	grid->cell_of[grid->count] = cell;
+	grid->ids[grid->count] = id;
+	grid->count++;
+	grid->cell_start[cell + 1]++;
+
+	return 1;
+
+}
+
+void dash_grid_sort(DashGrid *grid) {
+
+	int i, num_cells;
+
+	num_cells = grid->cols * grid->rows;
+
+	// Prefix sum turns the count of cell c, kept at [c + 1], into the
+	// end of its run. Scattering back to front walks each end down to
+	// the run's start and keeps insertion order within a cell.
+
+	for(i = 1; i <= num_cells; i++) {
+		grid->cell_start[i] += grid->cell_start[i - 1];
+	}
+
+	for(i = grid->count - 1; i >= 0; i--) {
+		grid->sorted[--grid->cell_start[grid->cell_of[i] + 1]] = grid->ids[i];
+	}
+
+	// Starts are now one place too far up, shift them down so cell c
+	// runs from [c] to [c + 1]
+
+	memmove(grid->cell_start, grid->cell_start + 1, num_cells * sizeof(int));
+	grid->cell_start[num_cells] = grid->count;
+
+}
+
+int dash_grid_query(DashGrid *grid, float x, float y, float reach, int *found, int max) {
+
+	int col, row, col_end, row_end, cell, i, num_found;
+
+	// Every cell the square of half size reach around the point touches
+
+	col_end = dash_grid_col(grid, x + reach);
+	row_end = dash_grid_row(grid, y + reach);
+	num_found = 0;
+
+	for(row = dash_grid_row(grid, y - reach); row <= row_end; row++) {
+
+		for(col = dash_grid_col(grid, x - reach); col <= col_end; col++) {
+
+			cell = row * grid->cols + col;
+
+			for(i = grid->cell_start[cell]; i < grid->cell_start[cell + 1]; i++) {
+
+				if(num_found == max) {
+					return num_found;
+				}
+
+				found[num_found++] = grid->sorted[i];
+
+			}
+
+		}
+
+	}
+
+	return num_found;
+
+}
+
+void dash_grid_free(DashGrid *grid) {
+
+	free(grid->cell_start);
+	free(grid->cell_of);
+	free(grid->ids);
+	free(grid->sorted);
+
+	memset(grid, 0, sizeof(DashGrid));
+
+}
+
+/******************************************************************************/
+/** End Program                                                              **/
+/******************************************************************************/
@@ -0,0 +1,61 @@
+/*
+
+    This file is part of Dash Graphics Library
+    Copyright 2017 Benjamin Collins
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy of this
+    software and associated documentation files (the "Software"), to deal in the Software
+    without restriction, including without limitation the rights to use, copy, modify, merge,
+    publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+    to whom the Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all copies or
+    substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+    INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+    PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+    FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+    OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+*/
+
+
+#ifndef DASHGL_GRID
+#define DASHGL_GRID
+
+	/**********************************************************************/
+	/** Typedef                                                          **/
+	/**********************************************************************/
+
+	// Uniform grid over the playfield for finding what might touch a
+	// point. Items are inserted with an id and position every tick, then
+	// sorted by cell with a counting sort, so each cell is one contiguous
+	// run of ids. Positions outside the playfield fall into the edge
+	// cells, queries clamp the same way and still find them.
+
+	typedef struct {
+		float cell_size;
+		int cols;
+		int rows;
+		int *cell_start;
+		int *cell_of;
+		int *ids;
+		int *sorted;
+		int capacity;
+		int count;
+	} DashGrid;
+
+	/**********************************************************************/
+	/** Uniform Grid                                                     **/
+	/**********************************************************************/
+
+	int dash_grid_init(DashGrid *grid, float width, float height, float cell_size, int capacity);
+	void dash_grid_clear(DashGrid *grid);
+	int dash_grid_insert(DashGrid *grid, int id, float x, float y);
+	void dash_grid_sort(DashGrid *grid);
+	int dash_grid_query(DashGrid *grid, float x, float y, float reach, int *found, int max);
+	void dash_grid_free(DashGrid *grid);
+
+#endif
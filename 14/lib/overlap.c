@@ -0,0 +1,324 @@
+/*
+    This file is part of Dash Graphics Library
+    Copyright 2017 Benjamin Collins
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy of this
+    software and associated documentation files (the "Software"), to deal in the Software
+    without restriction, including without limitation the rights to use, copy, modify, merge,
+    publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+    to whom the Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all copies or
+    substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+    INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+    PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+    FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+    OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+*/
+#include <stdint.h>
+#include "overlap.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define DASH_OVERLAP_X86
+#endif
+
+/******************************************************************************/
+/** Circle Overlap                                                           **/
+/******************************************************************************/
+
+// Each kernel tests one point against groups of eight positions and sets
+// bit i when position i is within the squared radius, the same test as
+// dx*dx + dy*dy <= radius_sq done one pair at a time
+
+typedef uint64_t (*DashOverlapKernel)(float, float, const float*, const float*, int, float);
+
+// Swept kernels test the segment from (x, y) along (dx, dy) instead. The
+// closest point to a position is at t = f.d / d.d along it, clamped to
+// the segment, where f runs from the start to the position. The caller
+// passes 1 / d.d, or 0 for a segment that doesn't move so t stays 0.
+
+typedef uint64_t (*DashSweptKernel)(float, float, float, float, float, const float*, const float*, int, float);
+
+static uint64_t dash_overlap_scalar(float x, float y, const float *xs, const float *ys, int count, float radius_sq) {
+
+	int i;
+	float dx, dy;
+	uint64_t mask;
+
+	mask = 0;
+
+	for(i = 0; i < count; i++) {
+		dx = xs[i] - x;
+		dy = ys[i] - y;
+		if(dx * dx + dy * dy <= radius_sq) {
+			mask |= 1ULL << i;
+		}
+	}
+
+	return mask;
+
+}
+
+static uint64_t dash_swept_scalar(float x, float y, float dx, float dy, float inv_len_sq, const float *xs, const float *ys, int count, float radius_sq) {
+
+	int i;
+	float fx, fy, t;
+	uint64_t mask;
+
+	mask = 0;
+
+	for(i = 0; i < count; i++) {
+
+		fx = xs[i] - x;
+		fy = ys[i] - y;
+		t = (fx * dx + fy * dy) * inv_len_sq;
+		t = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+
+		fx -= t * dx;
+		fy -= t * dy;
+		if(fx * fx + fy * fy <= radius_sq) {
+			mask |= 1ULL << i;
+		}
+
+	}
+
+	return mask;
+
+}
+
+#ifdef DASH_OVERLAP_X86
+
+__attribute__((target("sse2")))
+static uint64_t dash_overlap_sse2(float x, float y, const float *xs, const float *ys, int count, float radius_sq) {
+
+	int i;
+	__m128 px, py, r, dx, dy, lo, hi;
+	uint64_t mask;
+
+	px = _mm_set1_ps(x);
+	py = _mm_set1_ps(y);
+	r = _mm_set1_ps(radius_sq);
+	mask = 0;
+
+	for(i = 0; i < count; i += DASH_OVERLAP_LANES) {
+
+		dx = _mm_sub_ps(_mm_loadu_ps(xs + i), px);
+		dy = _mm_sub_ps(_mm_loadu_ps(ys + i), py);
+		lo = _mm_cmple_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), r);
+
+		dx = _mm_sub_ps(_mm_loadu_ps(xs + i + 4), px);
+		dy = _mm_sub_ps(_mm_loadu_ps(ys + i + 4), py);
+		hi = _mm_cmple_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), r);
+
+		mask |= (uint64_t)(_mm_movemask_ps(lo) | (_mm_movemask_ps(hi) << 4)) << i;
+
+	}
+
+	return mask;
+
+}
+
+__attribute__((target("sse2")))
+static uint64_t dash_swept_sse2(float x, float y, float dx, float dy, float inv_len_sq, const float *xs, const float *ys, int count, float radius_sq) {
+
+	int i;
+	__m128 px, py, vx, vy, inv, r, zero, one, fx, fy, t, d;
+	uint64_t mask;
+
+	px = _mm_set1_ps(x);
+	py = _mm_set1_ps(y);
+	vx = _mm_set1_ps(dx);
+	vy = _mm_set1_ps(dy);
+	inv = _mm_set1_ps(inv_len_sq);
+	r = _mm_set1_ps(radius_sq);
+	zero = _mm_setzero_ps();
+	one = _mm_set1_ps(1.0f);
+	mask = 0;
+
+	for(i = 0; i < count; i += 4) {
+
+		fx = _mm_sub_ps(_mm_loadu_ps(xs + i), px);
+		fy = _mm_sub_ps(_mm_loadu_ps(ys + i), py);
+		t = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(fx, vx), _mm_mul_ps(fy, vy)), inv);
+		t = _mm_min_ps(_mm_max_ps(t, zero), one);
+
+		fx = _mm_sub_ps(fx, _mm_mul_ps(t, vx));
+		fy = _mm_sub_ps(fy, _mm_mul_ps(t, vy));
+		d = _mm_add_ps(_mm_mul_ps(fx, fx), _mm_mul_ps(fy, fy));
+
+		mask |= (uint64_t)_mm_movemask_ps(_mm_cmple_ps(d, r)) << i;
+
+	}
+
+	return mask;
+
+}
+
+__attribute__((target("avx2")))
+static uint64_t dash_overlap_avx2(float x, float y, const float *xs, const float *ys, int count, float radius_sq) {
+
+	int i;
+	__m256 px, py, r, dx, dy, d;
+	uint64_t mask;
+
+	px = _mm256_set1_ps(x);
+	py = _mm256_set1_ps(y);
+	r = _mm256_set1_ps(radius_sq);
+	mask = 0;
+
+	for(i = 0; i < count; i += DASH_OVERLAP_LANES) {
+
+		dx = _mm256_sub_ps(_mm256_loadu_ps(xs + i), px);
+		dy = _mm256_sub_ps(_mm256_loadu_ps(ys + i), py);
+		d = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+
+		mask |= (uint64_t)_mm256_movemask_ps(_mm256_cmp_ps(d, r, _CMP_LE_OQ)) << i;
+
+	}
+
+	return mask;
+
+}
+
+__attribute__((target("avx2")))
+static uint64_t dash_swept_avx2(float x, float y, float dx, float dy, float inv_len_sq, const float *xs, const float *ys, int count, float radius_sq) {
+
+	int i;
+	__m256 px, py, vx, vy, inv, r, zero, one, fx, fy, t, d;
+	uint64_t mask;
+
+	px = _mm256_set1_ps(x);
+	py = _mm256_set1_ps(y);
+	vx = _mm256_set1_ps(dx);
+	vy = _mm256_set1_ps(dy);
+	inv = _mm256_set1_ps(inv_len_sq);
+	r = _mm256_set1_ps(radius_sq);
+	zero = _mm256_setzero_ps();
+	one = _mm256_set1_ps(1.0f);
+	mask = 0;
+
+	for(i = 0; i < count; i += DASH_OVERLAP_LANES) {
+
+		fx = _mm256_sub_ps(_mm256_loadu_ps(xs + i), px);
+		fy = _mm256_sub_ps(_mm256_loadu_ps(ys + i), py);
+		t = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(fx, vx), _mm256_mul_ps(fy, vy)), inv);
+		t = _mm256_min_ps(_mm256_max_ps(t, zero), one);
+
+		fx = _mm256_sub_ps(fx, _mm256_mul_ps(t, vx));
+		fy = _mm256_sub_ps(fy, _mm256_mul_ps(t, vy));
+		d = _mm256_add_ps(_mm256_mul_ps(fx, fx), _mm256_mul_ps(fy, fy));
+
+		mask |= (uint64_t)_mm256_movemask_ps(_mm256_cmp_ps(d, r, _CMP_LE_OQ)) << i;
+
+	}
+
+	return mask;
+
+}
+
+#endif
+
+static DashOverlapKernel dash_overlap_kernel = dash_overlap_scalar;
+static DashSweptKernel dash_swept_kernel = dash_swept_scalar;
+
+int dash_overlap_init() {
+
+	// Widest the processor runs, checked once at startup
+
+	if(dash_overlap_use(DASH_OVERLAP_AVX2)) {
+		return DASH_OVERLAP_AVX2;
+	}
+
+	if(dash_overlap_use(DASH_OVERLAP_SSE2)) {
+		return DASH_OVERLAP_SSE2;
+	}
+
+	dash_overlap_use(DASH_OVERLAP_SCALAR);
+	return DASH_OVERLAP_SCALAR;
+
+}
+
+int dash_overlap_use(int kernel) {
+
+	switch(kernel) {
+		case DASH_OVERLAP_SCALAR:
+			dash_overlap_kernel = dash_overlap_scalar;
+			dash_swept_kernel = dash_swept_scalar;
+			return 1;
+#ifdef DASH_OVERLAP_X86
+		case DASH_OVERLAP_SSE2:
+			if(!__builtin_cpu_supports("sse2")) {
+				return 0;
+			}
+			dash_overlap_kernel = dash_overlap_sse2;
+			dash_swept_kernel = dash_swept_sse2;
+			return 1;
+		case DASH_OVERLAP_AVX2:
+			if(!__builtin_cpu_supports("avx2")) {
+				return 0;
+			}
+			dash_overlap_kernel = dash_overlap_avx2;
+			dash_swept_kernel = dash_swept_avx2;
+			return 1;
+#endif
+	}
+
+	return 0;
+
+}
+
+uint64_t dash_overlap(float x, float y, const float *xs, const float *ys, int count, float radius_sq) {
+
+	uint64_t mask;
+
+	// Up to DASH_OVERLAP_MAX positions, bit i of the result for position i.
+	// Any past that don't fit in the mask and are left out.
+
+	if(count > DASH_OVERLAP_MAX) {
+		count = DASH_OVERLAP_MAX;
+	}
+
+	mask = dash_overlap_kernel(x, y, xs, ys, count, radius_sq);
+
+	if(count < DASH_OVERLAP_MAX) {
+		mask &= (1ULL << count) - 1;
+	}
+
+	return mask;
+
+}
+
+uint64_t dash_overlap_swept(float x0, float y0, float x1, float y1, const float *xs, const float *ys, int count, float radius_sq) {
+
+	float dx, dy, len_sq;
+	uint64_t mask;
+
+	// Like dash_overlap for everything the point passes on its way from
+	// (x0, y0) to (x1, y1), so a fast one can't skip over a position
+
+	if(count > DASH_OVERLAP_MAX) {
+		count = DASH_OVERLAP_MAX;
+	}
+
+	dx = x1 - x0;
+	dy = y1 - y0;
+	len_sq = dx * dx + dy * dy;
+
+	mask = dash_swept_kernel(x0, y0, dx, dy, len_sq > 0.0f ? 1.0f / len_sq : 0.0f, xs, ys, count, radius_sq);
+
+	if(count < DASH_OVERLAP_MAX) {
+		mask &= (1ULL << count) - 1;
+	}
+
+	return mask;
+
+}
+
+/******************************************************************************/
+/** End Program                                                              **/
+/******************************************************************************/
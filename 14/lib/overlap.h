@@ -0,0 +1,56 @@
+/*
+
+    This file is part of Dash Graphics Library
+    Copyright 2017 Benjamin Collins
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy of this
+    software and associated documentation files (the "Software"), to deal in the Software
+    without restriction, including without limitation the rights to use, copy, modify, merge,
+    publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+    to whom the Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all copies or
+    substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+    INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+    PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+    FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+    OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+*/
+
+
+#ifndef DASHGL_OVERLAP
+#define DASHGL_OVERLAP
+
+	#include <stdint.h>
+
+	/**********************************************************************/
+	/** Constants                                                        **/
+	/**********************************************************************/
+
+	// Positions are tested in groups of eight. Arrays passed in must be
+	// padded to a whole group, lanes past the count are read but masked.
+
+	#define DASH_OVERLAP_LANES 8
+	#define DASH_OVERLAP_PAD(n) (((n) + 7) & ~7)
+	#define DASH_OVERLAP_MAX 64
+
+	// Kernels for dash_overlap_use, best one is picked by dash_overlap_init
+
+	#define DASH_OVERLAP_SCALAR 0
+	#define DASH_OVERLAP_SSE2 1
+	#define DASH_OVERLAP_AVX2 2
+
+	/**********************************************************************/
+	/** Circle Overlap                                                   **/
+	/**********************************************************************/
+
+	int dash_overlap_init();
+	int dash_overlap_use(int kernel);
+	uint64_t dash_overlap(float x, float y, const float *xs, const float *ys, int count, float radius_sq);
+	uint64_t dash_overlap_swept(float x0, float y0, float x1, float y1, const float *xs, const float *ys, int count, float radius_sq);
+
+#endif
@@ -0,0 +1,141 @@
+/*
+    This file is part of Dash Graphics Library
+    Copyright 2017 Benjamin Collins
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy of this
+    software and associated documentation files (the "Software"), to deal in the Software
+    without restriction, including without limitation the rights to use, copy, modify, merge,
+    publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+    to whom the Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all copies or
+    substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+    INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+    PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+    FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+    OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+*/
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "slots.h"
+
+/******************************************************************************/
+/** Slot Allocator                                                           **/
+/******************************************************************************/
+
+int dash_slots_init(DashSlots *slots, int capacity) {
+
+	int tail;
+
+	memset(slots, 0, sizeof(DashSlots));
+
+	slots->num_words = (capacity + 63) / 64;
+	slots->words = (uint64_t*)calloc(slots->num_words, sizeof(uint64_t));
+	if(slots->words == NULL) {
+		return 0;
+	}
+
+	// Mark the unused end of the last word as taken
+
+	tail = capacity % 64;
+	if(tail != 0) {
+		slots->words[slots->num_words - 1] = ~0ULL << tail;
+	}
+
+	slots->capacity = capacity;
+	return 1;
+
+}
+
+int dash_slots_alloc(DashSlots *slots) {
+
+	int i, bit;
+	uint64_t free_bits;
+
+	// Every word before first_free is full
+
+	for(i = slots->first_free; i < slots->num_words; i++) {
+
+		free_bits = ~slots->words[i];
+		if(free_bits == 0) {
+			continue;
+		}
+
+		bit = __builtin_ctzll(free_bits);
+		slots->words[i] |= 1ULL << bit;
+		slots->first_free = i;
+		slots->count++;
+
+		return i * 64 + bit;
+
+	}
+
+	slots->first_free = slots->num_words;
+	return -1;
+
+}
+
+void dash_slots_release(DashSlots *slots, int index) {
+
+	int word;
+
+	word = index / 64;
+	slots->words[word] &= ~(1ULL << (index % 64));
+	slots->count--;
+
+	if(word < slots->first_free) {
+		slots->first_free = word;
+	}
+
+}
+
+int dash_slots_next(DashSlots *slots, int index) {
+
+	int word;
+	uint64_t bits;
+
+	// First used slot at or after index, or -1. Releasing the slot being
+	// visited is fine, the walk only looks forward.
+
+	if(index >= slots->capacity) {
+		return -1;
+	}
+
+	word = index / 64;
+	bits = slots->words[word] & (~0ULL << (index % 64));
+
+	for(;;) {
+
+		// The padding bits are set, so anything found past the
+		// capacity means there is nothing left
+
+		if(bits != 0) {
+			index = word * 64 + __builtin_ctzll(bits);
+			return index < slots->capacity ? index : -1;
+		}
+
+		if(++word == slots->num_words) {
+			return -1;
+		}
+
+		bits = slots->words[word];
+
+	}
+
+}
+
+void dash_slots_free(DashSlots *slots) {
+
+	free(slots->words);
+	memset(slots, 0, sizeof(DashSlots));
+
+}
+
+/******************************************************************************/
+/** End Program                                                              **/
+/******************************************************************************/
@@ -0,0 +1,57 @@
+/*
+
+    This file is part of Dash Graphics Library
+    Copyright 2017 Benjamin Collins
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy of this
+    software and associated documentation files (the "Software"), to deal in the Software
+    without restriction, including without limitation the rights to use, copy, modify, merge,
+    publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+    to whom the Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all copies or
+    substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+    INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+    PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+    FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+    OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+*/
+
+
+#ifndef DASHGL_SLOTS
+#define DASHGL_SLOTS
+
+	#include <stdint.h>
+
+	/**********************************************************************/
+	/** Typedef                                                          **/
+	/**********************************************************************/
+
+	// Occupancy of a fixed array of slots, one bit per slot packed into
+	// 64 bit words. Finding a free slot or the next used one skips whole
+	// words at a time and takes the lowest bit with count trailing zeros.
+	// Bits past the capacity stay set, so they are never handed out.
+
+	typedef struct {
+		uint64_t *words;
+		int num_words;
+		int capacity;
+		int count;
+		int first_free;
+	} DashSlots;
+
+	/**********************************************************************/
+	/** Slot Allocator                                                   **/
+	/**********************************************************************/
+
+	int dash_slots_init(DashSlots *slots, int capacity);
+	int dash_slots_alloc(DashSlots *slots);
+	void dash_slots_release(DashSlots *slots, int index);
+	int dash_slots_next(DashSlots *slots, int index);
+	void dash_slots_free(DashSlots *slots);
+
+#endif
@@ -19,10 +19,18 @@
 #include <GL/glew.h>
 #include <gtk/gtk.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
 #include "lib/dashgl.h"
+#include "lib/slots.h"
+#include "lib/grid.h"
+#include "lib/overlap.h"
 
 #define WIDTH 640.0f
 #define HEIGHT 480.0f
+#define NUM_ENEMIES 40
+#define NUM_ENEMY_BULLETS 20
+#define BENCH_ROUNDS 10000000
 
 static void on_realize(GtkGLArea *area);
 static void on_render(GtkGLArea *area, GdkGLContext *context);
@@ -30,19 +38,25 @@ static gboolean on_idle(gpointer data);
 static gint on_destroy(GtkWidget *widget);
 static gboolean on_keydown(GtkWidget *widget, GdkEventKey *event);
 static gboolean on_keyup(GtkWidget *widget, GdkEventKey *event);
+static int run_bench();
+static void formation_bounds();
 
 GLuint program, glInit;
 GLuint vao;
 GLint attribute_coord2d, uniform_mvp;
 GtkWidget *glArea;
 
+// Which bullets are live is kept in a slot allocator next to each array
+
 typedef struct {
 	vec3 pos;
-	gboolean active;
 } Bullet;
 
+// Enemies are placed by their offset from the formation's origin, so the
+// whole grid moves by moving the origin
+
 typedef struct {
-	vec3 pos;
+	vec3 offset;
 	gboolean active;
 	int type;
 } Enemy;
@@ -56,15 +70,23 @@ struct {
 	gboolean right_down;
 	gboolean space_down;
 	Bullet *bullets;
+	DashSlots bullet_slots;
 	int num_bullets;
 	float bullet_radius;
+	float radius;
 } player;
 
 struct {
-	Enemy bit[40];
+	Enemy bit[NUM_ENEMIES];
+	vec3 origin;
+	vec3 box_min;
+	vec3 box_max;
+	int num_alive;
+	DashGrid grid;
 	GLuint vbo[4];
 	GLuint bullet_vbo;
-	Bullet bullets[20];
+	Bullet bullets[NUM_ENEMY_BULLETS];
+	DashSlots bullet_slots;
 	float dx, dy;
 	float radius;
 	float bullet_radius;
@@ -73,6 +95,17 @@ struct {
 int main(int argc, char *argv[]) {
 
 	GtkWidget *window;
+	int i;
+
+	// --bench-overlap times the collision kernels and exits
+
+	for(i = 1; i < argc; i++) {
+		if(strcmp(argv[i], "--bench-overlap") == 0) {
+			return run_bench();
+		}
+	}
+
+	dash_overlap_init();
 
 	gtk_init(&argc, &argv);
 
@@ -143,9 +176,11 @@ static void on_realize(GtkGLArea *area) {
 	player.right_down = FALSE;
 	player.space_down = FALSE;
 	player.bullet_radius = 5.0f;
+	player.radius = 20.0f;
 
-	for(i = 0; i < player.num_bullets; i++) {
-		player.bullets[i].active = FALSE;
+	if(!dash_slots_init(&player.bullet_slots, player.num_bullets)) {
+		fprintf(stderr, "Bullet slot creation error\n");
+		exit(1);
 	}
 
 	GLfloat triangle_vertices[] = {
@@ -201,20 +236,35 @@ static void on_realize(GtkGLArea *area) {
 	enemies.radius = 24.0f;
 	enemies.bullet_radius = 5.0f;
 
-	for(i = 0; i < 40; i++) {
+	// The origin is the center of the top left enemy
+
+	enemies.origin[0] = 4.0f + enemies.radius;
+	enemies.origin[1] = HEIGHT - (4.0f + enemies.radius);
+	enemies.origin[2] = 0.0f;
+
+	for(i = 0; i < NUM_ENEMIES; i++) {
 
 		col = i % 10;
 		row = i / 10;
 
 		enemies.bit[i].active = TRUE;
 		enemies.bit[i].type = row;
-		enemies.bit[i].pos[0] = 4.0f + enemies.radius + (2*enemies.radius + 4.0f) * col;
-		enemies.bit[i].pos[1] = 4.0f + enemies.radius + (2*enemies.radius + 4.0f) * row;
-		enemies.bit[i].pos[1] = HEIGHT - enemies.bit[i].pos[1];
-		enemies.bit[i].pos[2] = 0.0f;
+		enemies.bit[i].offset[0] = (2*enemies.radius + 4.0f) * col;
+		enemies.bit[i].offset[1] = -(2*enemies.radius + 4.0f) * row;
+		enemies.bit[i].offset[2] = 0.0f;
 
 	}
 
+	formation_bounds();
+
+	// Cells as wide as an enemy, so a bullet only ever has to look at
+	// the cells next to its own
+
+	if(!dash_grid_init(&enemies.grid, WIDTH, HEIGHT, 2 * enemies.radius, NUM_ENEMIES)) {
+		fprintf(stderr, "Collision grid creation error\n");
+		exit(1);
+	}
+
 	glGenBuffers(1, &enemies.bullet_vbo);
 	glBindBuffer(GL_ARRAY_BUFFER, enemies.bullet_vbo);
 	glBufferData(
@@ -226,10 +276,9 @@ static void on_realize(GtkGLArea *area) {
 	
 	printf("Player VBO 1: %d\n", player.bullet_vbo);
 
-	for(i = 0; i < 20; i++) {
-		
-		enemies.bullets[i].active = FALSE;
-
+	if(!dash_slots_init(&enemies.bullet_slots, NUM_ENEMY_BULLETS)) {
+		fprintf(stderr, "Bullet slot creation error\n");
+		exit(1);
 	}
 
 	GLfloat enemy_vertices[4][12] = {
@@ -321,6 +370,7 @@ static void on_render(GtkGLArea *area, GdkGLContext *context) {
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 	
 	int i;
+	vec3 pos;
 	mat4 mvp;
 
 	// Draw Player
@@ -337,10 +387,7 @@ static void on_render(GtkGLArea *area, GdkGLContext *context) {
 		0
 	);
 
-	for(i = 0; i < player.num_bullets; i++) {
-		if(!player.bullets[i].active) {
-			continue;
-		}
+	for(i = dash_slots_next(&player.bullet_slots, 0); i != -1; i = dash_slots_next(&player.bullet_slots, i + 1)) {
 		
 		mat4_translate(player.bullets[i].pos, mvp);
 		glUniformMatrix4fv(uniform_mvp, 1, GL_FALSE, mvp);
@@ -385,11 +432,7 @@ static void on_render(GtkGLArea *area, GdkGLContext *context) {
 
 	/*
 
-	for(i = 0; i < 20; i++) {
-
-		if(!enemies.bullets[i].active) {
-			continue;
-		}
+	for(i = dash_slots_next(&enemies.bullet_slots, 0); i != -1; i = dash_slots_next(&enemies.bullet_slots, i + 1)) {
 		
 		mat4_translate(enemies.bullets[i].pos, mvp);
 		glUniformMatrix4fv(uniform_mvp, 1, GL_FALSE, mvp);
@@ -412,12 +455,13 @@ static void on_render(GtkGLArea *area, GdkGLContext *context) {
 	);
 
 	glBindBuffer(GL_ARRAY_BUFFER, player.ship_vbo);
-	for(i = 0; i < 40; i++) {
+	for(i = 0; i < NUM_ENEMIES; i++) {
 		if(!enemies.bit[i].active) {
 			continue;
 		}
 		
-		mat4_translate(enemies.bit[i].pos, mvp);
+		vec3_add(enemies.origin, enemies.bit[i].offset, pos);
+		mat4_translate(pos, mvp);
 		glUniformMatrix4fv(uniform_mvp, 1, GL_FALSE, mvp);
 		glDrawArrays(GL_TRIANGLES, 0, 6);
 
@@ -430,8 +474,15 @@ static void on_render(GtkGLArea *area, GdkGLContext *context) {
 
 static gboolean on_idle(gpointer data) {
 
-	int i, k, move_down, shoot;
-	float dx, dy, radius;
+	int i, k, n, move_down, shoot, num_near;
+	// Collision candidates, enemies near a bullet or enemy bullets, in
+	// arrays padded for the overlap kernels
+
+	int near[DASH_OVERLAP_PAD(NUM_ENEMIES)];
+	float near_x[DASH_OVERLAP_PAD(NUM_ENEMIES)];
+	float near_y[DASH_OVERLAP_PAD(NUM_ENEMIES)];
+	uint64_t hits;
+	float radius, from_y;
 
 	if(glInit == 0) {
 		return FALSE;
@@ -453,81 +504,111 @@ static gboolean on_idle(gpointer data) {
 
 	radius = enemies.radius * enemies.radius;
 
-	for(i = 0; i < player.num_bullets; i++) {
-		if(!player.bullets[i].active) {
-			continue;
+	// Bin the live enemies once per tick, each bullet then only tests the
+	// ones in the cells around it
+
+	dash_grid_clear(&enemies.grid);
+
+	for(k = 0; k < NUM_ENEMIES; k++) {
+		if(enemies.bit[k].active) {
+			dash_grid_insert(
+				&enemies.grid,
+				k,
+				enemies.origin[0] + enemies.bit[k].offset[0],
+				enemies.origin[1] + enemies.bit[k].offset[1]
+			);
 		}
+	}
+
+	dash_grid_sort(&enemies.grid);
+
+	// Releasing the visited slot is safe, the walk only looks ahead
+
+	for(i = dash_slots_next(&player.bullet_slots, 0); i != -1; i = dash_slots_next(&player.bullet_slots, i + 1)) {
 		
 		if(player.bullets[i].pos[1] - player.bullet_radius > HEIGHT) {
-			player.bullets[i].active = FALSE;	
+			dash_slots_release(&player.bullet_slots, i);
+			continue;
 		}
 
+		from_y = player.bullets[i].pos[1];
 		player.bullets[i].pos[1] += player.dy;
-		
-		for(k = 0; k < 40; k++) {
-			
-			if(!enemies.bit[k].active) {
-				continue;
-			}
-			
-			continue;
 
-			dx = player.bullets[i].pos[0] - enemies.bit[k].pos[0];
-			dy = player.bullets[i].pos[1] - enemies.bit[k].pos[1];
-			
-			dx = dx * dx;
-			dy = dy * dy;
-			
-			if(radius < dx + dy) {
-				continue;
+		// Everything along the step counts, so look around its middle
+		// far enough to reach both ends
+
+		num_near = dash_grid_query(
+			&enemies.grid,
+			player.bullets[i].pos[0],
+			from_y + 0.5f * player.dy,
+			enemies.radius + 0.5f * fabsf(player.dy),
+			near,
+			NUM_ENEMIES
+		);
+
+		// Pack the ones still alive, enemies hit by an earlier bullet
+		// this tick are still in the grid
+
+		k = 0;
+
+		for(n = 0; n < num_near; n++) {
+			if(enemies.bit[near[n]].active) {
+				near[k] = near[n];
+				near_x[k] = enemies.origin[0] + enemies.bit[near[n]].offset[0];
+				near_y[k] = enemies.origin[1] + enemies.bit[near[n]].offset[1];
+				k++;
 			}
+		}
 
+		hits = dash_overlap_swept(
+			player.bullets[i].pos[0],
+			from_y,
+			player.bullets[i].pos[0],
+			player.bullets[i].pos[1],
+			near_x,
+			near_y,
+			k,
+			radius
+		);
 
-			player.bullets[i].active = FALSE;
-			enemies.bit[k].active = FALSE;
-				
-			break;
-			
+		// A bullet takes out one of the enemies it overlaps, the lowest
+		// candidate, not necessarily the first one along its path
+
+		if(hits != 0) {
+			dash_slots_release(&player.bullet_slots, i);
+			enemies.bit[near[__builtin_ctzll(hits)]].active = FALSE;
+			formation_bounds();
 		}
+
 	}
 
+	// The formation moves as one, and only its outermost live members
+	// can touch an edge
+
+	enemies.origin[0] += enemies.dx;
+
 	move_down = 0;
 
-	for(i = 0; i < 40; i++) {
+	if(enemies.num_alive > 0) {
+		if(enemies.origin[0] + enemies.box_min[0] - enemies.radius < 0.0) {
+			move_down = 1;
+		} else if(enemies.origin[0] + enemies.box_max[0] + enemies.radius > WIDTH) {
+			move_down = 1;
+		}
+	}
+
+	for(i = 0; i < NUM_ENEMIES; i++) {
 
 		if(!enemies.bit[i].active) {
 			continue;
 		}
 
-		enemies.bit[i].pos[0] += enemies.dx;
-
-		if(enemies.bit[i].pos[0] - enemies.radius < 0.0) {
-			move_down = 1;
-		} else if(enemies.bit[i].pos[0] + enemies.radius > WIDTH) {
-			move_down = 1;
-		}
-		
 		if(rand() % 1000 > 995) {
 			
-			shoot = 0;
+			shoot = dash_slots_alloc(&enemies.bullet_slots);
 
-			for(k = 0; k < 20; k++) {
-
-				if(enemies.bullets[k].active) {
-					continue;
-				}
-				
-				if(shoot) {
-					continue;
-				}
-				
-				shoot = 1;
-				enemies.bullets[k].active = TRUE;
-
-				enemies.bullets[k].pos[0] = enemies.bit[i].pos[0];
-				enemies.bullets[k].pos[1] = enemies.bit[i].pos[1];
-				enemies.bullets[k].pos[2] = enemies.bit[i].pos[2];
-				
+			if(shoot != -1) {
+				vec3_add(enemies.origin, enemies.bit[i].offset, enemies.bullets[shoot].pos);
 			}
 
 		}
@@ -535,31 +616,48 @@ static gboolean on_idle(gpointer data) {
 	}
 	
 	if(move_down) {
-		
 		enemies.dx = -enemies.dx;
-
-		for(i = 0; i < 40; i++) {
-			if(!enemies.bit[i].active) {
-				continue;
-			}
-
-			enemies.bit[i].pos[1] -= 2.0f;
-		}
-
+		enemies.origin[1] -= 2.0f;
 	}
 
-	for(i = 0; i < 20; i++) {
+	num_near = 0;
 
-		if(!enemies.bullets[i].active) {
-			continue;
-		}
+	for(i = dash_slots_next(&enemies.bullet_slots, 0); i != -1; i = dash_slots_next(&enemies.bullet_slots, i + 1)) {
 		
+		near_x[num_near] = enemies.bullets[i].pos[0];
+		near_y[num_near] = enemies.bullets[i].pos[1];
 		enemies.bullets[i].pos[1] += enemies.dy;
 	
 		if(enemies.bullets[i].pos[1] < -15.0f) {
-			enemies.bullets[i].active = FALSE;
+			dash_slots_release(&enemies.bullet_slots, i);
+			continue;
 		}
 
+		near[num_near] = i;
+		num_near++;
+
+	}
+
+	// Same test the other way around, the player against every enemy
+	// bullet still on screen. They all move the same way, so seen from
+	// the bullets' starting points the player sweeps back along it.
+
+	radius = player.radius + enemies.bullet_radius;
+
+	hits = dash_overlap_swept(
+		player.pos[0],
+		player.pos[1],
+		player.pos[0],
+		player.pos[1] - enemies.dy,
+		near_x,
+		near_y,
+		num_near,
+		radius * radius
+	);
+
+	while(hits != 0) {
+		dash_slots_release(&enemies.bullet_slots, near[__builtin_ctzll(hits)]);
+		hits &= hits - 1;
 	}
 
 	gtk_widget_queue_draw(glArea);
@@ -591,18 +689,12 @@ static gboolean on_keydown(GtkWidget *widget, GdkEventKey *event) {
 				
 				player.space_down = TRUE;
 				
-				for(i = 0; i < player.num_bullets; i++) {
-					if(player.bullets[i].active) {
-						continue;
-					}
-					
-					player.bullets[i].active = TRUE;
-					
+				i = dash_slots_alloc(&player.bullet_slots);
+
+				if(i != -1) {
 					player.bullets[i].pos[0] = player.pos[0];
 					player.bullets[i].pos[1] = player.pos[1] + 5.0f;
 					player.bullets[i].pos[2] = player.pos[2];
-
-					break;
 				}
 			}
 		break;
@@ -626,3 +718,115 @@ static gboolean on_keyup(GtkWidget *widget, GdkEventKey *event) {
 
 }
 
+/*****************************************************************************
+ * run bench
+ *****************************************************************************/
+
+static int run_bench() {
+
+	const char *names[] = { "scalar", "sse2", "avx2" };
+	float xs[DASH_OVERLAP_MAX], ys[DASH_OVERLAP_MAX];
+	gint64 start, elapsed, swept;
+	unsigned long hits;
+	int i, kernel;
+
+	// A full batch of positions over the playfield, each one in turn is
+	// tested against all of them at an enemy's radius
+
+	for(i = 0; i < DASH_OVERLAP_MAX; i++) {
+		xs[i] = (float)(rand() % (int)WIDTH);
+		ys[i] = (float)(rand() % (int)HEIGHT);
+	}
+
+	for(kernel = DASH_OVERLAP_SCALAR; kernel <= DASH_OVERLAP_AVX2; kernel++) {
+
+		if(!dash_overlap_use(kernel)) {
+			printf("%-6s not supported\n", names[kernel]);
+			continue;
+		}
+
+		hits = 0;
+		start = g_get_monotonic_time();
+
+		for(i = 0; i < BENCH_ROUNDS; i++) {
+			hits += __builtin_popcountll(dash_overlap(
+				xs[i % DASH_OVERLAP_MAX],
+				ys[i % DASH_OVERLAP_MAX],
+				xs,
+				ys,
+				DASH_OVERLAP_MAX,
+				24.0f * 24.0f
+			));
+		}
+
+		elapsed = g_get_monotonic_time() - start;
+
+		// Same again with each point moving a bullet's step
+
+		start = g_get_monotonic_time();
+
+		for(i = 0; i < BENCH_ROUNDS; i++) {
+			hits += __builtin_popcountll(dash_overlap_swept(
+				xs[i % DASH_OVERLAP_MAX],
+				ys[i % DASH_OVERLAP_MAX],
+				xs[i % DASH_OVERLAP_MAX],
+				ys[i % DASH_OVERLAP_MAX] + 4.0f,
+				xs,
+				ys,
+				DASH_OVERLAP_MAX,
+				24.0f * 24.0f
+			));
+		}
+
+		swept = g_get_monotonic_time() - start;
+
+		printf(
+			"%-6s %.3f pairs per ns, swept %.3f pairs per ns, %lu hits\n",
+			names[kernel],
+			(double)BENCH_ROUNDS * DASH_OVERLAP_MAX / (MAX(elapsed, 1) * 1000.0),
+			(double)BENCH_ROUNDS * DASH_OVERLAP_MAX / (MAX(swept, 1) * 1000.0),
+			hits
+		);
+
+	}
+
+	return 0;
+
+}
+
+/*****************************************************************************
+ * formation bounds
+ *****************************************************************************/
+
+static void formation_bounds() {
+
+	int i, axis;
+
+	// Box around the offsets of the live enemies, only changes when one
+	// of them dies
+
+	enemies.num_alive = 0;
+
+	for(i = 0; i < NUM_ENEMIES; i++) {
+
+		if(!enemies.bit[i].active) {
+			continue;
+		}
+
+		for(axis = 0; axis < 3; axis++) {
+
+			if(enemies.num_alive == 0 || enemies.bit[i].offset[axis] < enemies.box_min[axis]) {
+				enemies.box_min[axis] = enemies.bit[i].offset[axis];
+			}
+
+			if(enemies.num_alive == 0 || enemies.bit[i].offset[axis] > enemies.box_max[axis]) {
+				enemies.box_max[axis] = enemies.bit[i].offset[axis];
+			}
+
+		}
+
+		enemies.num_alive++;
+
+	}
+
+}
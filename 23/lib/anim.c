@@ -0,0 +1,107 @@
+/*
+    This file is part of Dash Graphics Library
+    Copyright 2017 Benjamin Collins
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy of this
+    software and associated documentation files (the "Software"), to deal in the Software
+    without restriction, including without limitation the rights to use, copy, modify, merge,
+    publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+    to whom the Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all copies or
+    substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+    INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+    PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+    FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+    OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+*/
+#include <stdio.h>
+#include <GL/glew.h>
+#include "dashgl.h"
+#include "atlas.h"
+#include "anim.h"
+
+/******************************************************************************/
+/** Sprite Animation                                                         **/
+/******************************************************************************/
+
+int dash_anim_build(DashAnim *anim, DashAtlas *atlas, const DashFrame *frames, int num_frames) {
+
+	DashAtlasEntry *e;
+	GLfloat x, y;
+	int i;
+
+	if(num_frames > DASH_ANIM_MAX_FRAMES) {
+		fprintf(stderr, "Animation table holds at most %d frames\n", DASH_ANIM_MAX_FRAMES);
+		return 0;
+	}
+
+	for(i = 0; i < num_frames; i++) {
+
+		e = dash_atlas_find(atlas, frames[i].sheet);
+		if(e == NULL) {
+			fprintf(stderr, "%s is not in the atlas\n", frames[i].sheet);
+			return 0;
+		}
+
+		// Stored as the bottom-left and top-right texture coordinate,
+		// which is the bottom and top row of the rectangle in the image
+
+		x = (GLfloat)(e->x + frames[i].x);
+		y = (GLfloat)(e->y + frames[i].y);
+
+		anim->uv[i][0] = x / atlas->width;
+		anim->uv[i][1] = (y + frames[i].height) / atlas->height;
+		anim->uv[i][2] = (x + frames[i].width) / atlas->width;
+		anim->uv[i][3] = y / atlas->height;
+
+		anim->size[i][0] = frames[i].size[0];
+		anim->size[i][1] = frames[i].size[1];
+
+	}
+
+	anim->num_frames = num_frames;
+	return 1;
+
+}
+
+void dash_anim_upload(DashAnim *anim, GLuint program) {
+
+	const char *name;
+	GLint uniform;
+
+	dash_use_program(program);
+
+	name = "frame_uv";
+	uniform = glGetUniformLocation(program, name);
+	if(uniform == -1) {
+		fprintf(stderr, "Could not bind uniform %s\n", name);
+		return;
+	}
+
+	glUniform4fv(uniform, anim->num_frames, anim->uv[0]);
+
+	name = "frame_size";
+	uniform = glGetUniformLocation(program, name);
+	if(uniform == -1) {
+		fprintf(stderr, "Could not bind uniform %s\n", name);
+		return;
+	}
+
+	glUniform2fv(uniform, anim->num_frames, anim->size[0]);
+
+}
+
+int dash_anim_frame(const DashClip *clip, int tick) {
+
+	return clip->first + (tick / clip->ticks) % clip->count;
+
+}
+
+/******************************************************************************/
+/** End Program                                                              **/
+/******************************************************************************/
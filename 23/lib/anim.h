@@ -0,0 +1,72 @@
+/*
+
+    This file is part of Dash Graphics Library
+    Copyright 2017 Benjamin Collins
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy of this
+    software and associated documentation files (the "Software"), to deal in the Software
+    without restriction, including without limitation the rights to use, copy, modify, merge,
+    publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+    to whom the Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all copies or
+    substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+    INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+    PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+    FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+    OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+*/
+
+#ifndef DASHGL_ANIM
+#define DASHGL_ANIM
+
+	/**********************************************************************/
+	/** Constants                                                        **/
+	/**********************************************************************/
+
+	// Must match the array sizes in sdr/vertex_sprite.glsl
+
+	#define DASH_ANIM_MAX_FRAMES 64
+
+	/**********************************************************************/
+	/** Typedef                                                          **/
+	/**********************************************************************/
+
+	// A frame is a rectangle of a spritesheet in pixels, top-left origin,
+	// and the size it is drawn at in world units.
+
+	typedef struct {
+		const char *sheet;
+		int x, y;
+		int width, height;
+		GLfloat size[2];
+	} DashFrame;
+
+	// A clip is a run of consecutive frames in the frame table, each
+	// shown for the given number of ticks.
+
+	typedef struct {
+		int first;
+		int count;
+		int ticks;
+	} DashClip;
+
+	typedef struct {
+		GLfloat uv[DASH_ANIM_MAX_FRAMES][4];
+		GLfloat size[DASH_ANIM_MAX_FRAMES][2];
+		int num_frames;
+	} DashAnim;
+
+	/**********************************************************************/
+	/** Sprite Animation                                                 **/
+	/**********************************************************************/
+
+	int dash_anim_build(DashAnim *anim, DashAtlas *atlas, const DashFrame *frames, int num_frames);
+	void dash_anim_upload(DashAnim *anim, GLuint program);
+	int dash_anim_frame(const DashClip *clip, int tick);
+
+#endif
@@ -0,0 +1,357 @@
+/*
+    This file is part of Dash Graphics Library
+    Copyright 2017 Benjamin Collins
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy of this
+    software and associated documentation files (the "Software"), to deal in the Software
+    without restriction, including without limitation the rights to use, copy, modify, merge,
+    publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+    to whom the Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all copies or
+    substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+    INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+    PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+    FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+    OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <GL/glew.h>
+#include "dashgl.h"
+#include "atlas.h"
+
+/******************************************************************************/
+/** Skyline Packer                                                           **/
+/******************************************************************************/
+
+// The skyline is the top edge of everything packed so far, stored as a
+// list of horizontal segments from left to right. Each image is placed
+// on the segment that keeps the skyline lowest.
+
+typedef struct {
+	int x, y, width;
+} DashSkyline;
+
+static int dash_skyline_fit(DashSkyline *nodes, int n, int i, int w, int h, int size) {
+
+	int y, left;
+
+	if(nodes[i].x + w > size) {
+		return -1;
+	}
+
+	y = 0;
+	left = w;
+
+	while(left > 0) {
+
+		if(i == n) {
+			return -1;
+		}
+
+		if(nodes[i].y > y) {
+			y = nodes[i].y;
+		}
+
+		left -= nodes[i].width;
+		i++;
+
+	}
+
+	if(y + h > size) {
+		return -1;
+	}
+
+	return y;
+
+}
+
+static void dash_skyline_add(DashSkyline *nodes, int *n, int i, int x, int y, int w) {
+
+	int j, shrink;
+
+	memmove(&nodes[i + 1], &nodes[i], (*n - i) * sizeof(DashSkyline));
+	nodes[i].x = x;
+	nodes[i].y = y;
+	nodes[i].width = w;
+	(*n)++;
+
+	// Cut the segments now hidden under the new one
+
+	j = i + 1;
+	while(j < *n) {
+
+		shrink = nodes[i].x + nodes[i].width - nodes[j].x;
+		if(shrink <= 0) {
+			break;
+		}
+
+		nodes[j].x += shrink;
+		nodes[j].width -= shrink;
+
+		if(nodes[j].width > 0) {
+			break;
+		}
+
+		memmove(&nodes[j], &nodes[j + 1], (*n - j - 1) * sizeof(DashSkyline));
+		(*n)--;
+
+	}
+
+	// Merge neighbours that ended up at the same height
+
+	j = 0;
+	while(j < *n - 1) {
+
+		if(nodes[j].y != nodes[j + 1].y) {
+			j++;
+			continue;
+		}
+
+		nodes[j].width += nodes[j + 1].width;
+		memmove(&nodes[j + 1], &nodes[j + 2], (*n - j - 2) * sizeof(DashSkyline));
+		(*n)--;
+
+	}
+
+}
+
+static int dash_skyline_pack(DashAtlas *atlas, int *order, int size) {
+
+	DashSkyline nodes[DASH_ATLAS_MAX_ENTRIES * 2 + 2];
+	DashAtlasEntry *e;
+	int n, i, k, y, w, h, best, best_y, best_top, best_width;
+
+	nodes[0].x = 0;
+	nodes[0].y = 0;
+	nodes[0].width = size;
+	n = 1;
+
+	for(k = 0; k < atlas->num_entries; k++) {
+
+		e = &atlas->entries[order[k]];
+		w = e->width + DASH_ATLAS_PADDING;
+		h = e->height + DASH_ATLAS_PADDING;
+
+		best = -1;
+		best_y = 0;
+		best_top = size + 1;
+		best_width = size + 1;
+
+		for(i = 0; i < n; i++) {
+
+			y = dash_skyline_fit(nodes, n, i, w, h, size);
+			if(y == -1) {
+				continue;
+			}
+
+			if(y + h < best_top || (y + h == best_top && nodes[i].width < best_width)) {
+				best = i;
+				best_y = y;
+				best_top = y + h;
+				best_width = nodes[i].width;
+			}
+
+		}
+
+		if(best == -1) {
+			return 0;
+		}
+
+		e->x = nodes[best].x;
+		e->y = best_y;
+		dash_skyline_add(nodes, &n, best, e->x, e->y + h, w);
+
+	}
+
+	return 1;
+
+}
+
+/******************************************************************************/
+/** Texture Atlas                                                            **/
+/******************************************************************************/
+
+static int dash_atlas_by_name(const void *a, const void *b) {
+
+	return strcmp(((DashAtlasEntry*)a)->name, ((DashAtlasEntry*)b)->name);
+
+}
+
+static DashAtlasEntry *dash_atlas_sort_entries;
+
+static int dash_atlas_by_height(const void *a, const void *b) {
+
+	DashAtlasEntry *ea, *eb;
+
+	ea = &dash_atlas_sort_entries[*(int*)a];
+	eb = &dash_atlas_sort_entries[*(int*)b];
+
+	if(ea->height != eb->height) {
+		return eb->height - ea->height;
+	}
+
+	return eb->width - ea->width;
+
+}
+
+GLuint dash_atlas_build(DashAtlas *atlas, const char *directory) {
+
+	DIR *dir;
+	struct dirent *ent;
+	DashAtlasEntry *e;
+	unsigned char *pixels[DASH_ATLAS_MAX_ENTRIES];
+	unsigned char *data, *src, *dst;
+	GLenum formats[DASH_ATLAS_MAX_ENTRIES];
+	int order[DASH_ATLAS_MAX_ENTRIES];
+	int i, x, y, len, size, channels;
+	char path[256];
+
+	memset(atlas, 0, sizeof(DashAtlas));
+
+	dir = opendir(directory);
+	if(dir == NULL) {
+		fprintf(stderr, "Could not open %s for reading\n", directory);
+		return 0;
+	}
+
+	while((ent = readdir(dir)) != NULL) {
+
+		len = strlen(ent->d_name);
+		if(len < 4 || strcmp(ent->d_name + len - 4, ".png") != 0) {
+			continue;
+		}
+
+		if(len >= (int)sizeof(atlas->entries[0].name)) {
+			fprintf(stderr, "Atlas skipping %s, name too long\n", ent->d_name);
+			continue;
+		}
+
+		if(atlas->num_entries == DASH_ATLAS_MAX_ENTRIES) {
+			fprintf(stderr, "Atlas is full, skipping %s\n", ent->d_name);
+			continue;
+		}
+
+		strcpy(atlas->entries[atlas->num_entries++].name, ent->d_name);
+
+	}
+
+	closedir(dir);
+
+	// Sorted by name so the layout does not depend on readdir order
+
+	qsort(atlas->entries, atlas->num_entries, sizeof(DashAtlasEntry), dash_atlas_by_name);
+
+	for(i = 0; i < atlas->num_entries; i++) {
+
+		e = &atlas->entries[i];
+		snprintf(path, sizeof(path), "%s/%s", directory, e->name);
+		pixels[i] = dash_png_read(path, &e->width, &e->height, &formats[i]);
+		if(pixels[i] == NULL) {
+			fprintf(stderr, "Could not load %s into atlas\n", path);
+			exit(1);
+		}
+
+		order[i] = i;
+
+	}
+
+	// Tallest first, then grow the square until everything fits
+
+	dash_atlas_sort_entries = atlas->entries;
+	qsort(order, atlas->num_entries, sizeof(int), dash_atlas_by_height);
+
+	for(size = 64; size <= DASH_ATLAS_MAX_SIZE; size *= 2) {
+		if(dash_skyline_pack(atlas, order, size)) {
+			break;
+		}
+	}
+
+	if(size > DASH_ATLAS_MAX_SIZE) {
+		fprintf(stderr, "Spritesheets in %s do not fit in a %dx%d atlas\n",
+			directory, DASH_ATLAS_MAX_SIZE, DASH_ATLAS_MAX_SIZE);
+		exit(1);
+	}
+
+	atlas->width = size;
+	atlas->height = size;
+
+	// Copy every sheet into place, expanding RGB to RGBA
+
+	data = (unsigned char*)calloc(size * size, 4);
+
+	for(i = 0; i < atlas->num_entries; i++) {
+
+		e = &atlas->entries[i];
+		channels = formats[i] == GL_RGBA ? 4 : 3;
+
+		for(y = 0; y < e->height; y++) {
+
+			src = &pixels[i][y * e->width * channels];
+			dst = &data[((e->y + y) * size + e->x) * 4];
+
+			if(channels == 4) {
+				memcpy(dst, src, e->width * 4);
+				continue;
+			}
+
+			for(x = 0; x < e->width; x++) {
+				dst[x*4 + 0] = src[x*3 + 0];
+				dst[x*4 + 1] = src[x*3 + 1];
+				dst[x*4 + 2] = src[x*3 + 2];
+				dst[x*4 + 3] = 255;
+			}
+
+		}
+
+		free(pixels[i]);
+
+		e->uv[0] = (GLfloat)e->x / size;
+		e->uv[1] = (GLfloat)e->y / size;
+		e->uv[2] = (GLfloat)(e->x + e->width) / size;
+		e->uv[3] = (GLfloat)(e->y + e->height) / size;
+
+	}
+
+	// Textures sample nearest, which keeps neighbouring sheets from
+	// bleeding in
+
+	atlas->texture = dash_texture_create(size, size, GL_RGBA, data);
+	free(data);
+
+	return atlas->texture;
+
+}
+
+DashAtlasEntry *dash_atlas_find(DashAtlas *atlas, const char *name) {
+
+	int i;
+
+	for(i = 0; i < atlas->num_entries; i++) {
+		if(strcmp(atlas->entries[i].name, name) == 0) {
+			return &atlas->entries[i];
+		}
+	}
+
+	return NULL;
+
+}
+
+void dash_atlas_free(DashAtlas *atlas) {
+
+	glDeleteTextures(1, &atlas->texture);
+	atlas->texture = 0;
+	atlas->num_entries = 0;
+
+}
+
+/******************************************************************************/
+/** End Program                                                              **/
+/******************************************************************************/
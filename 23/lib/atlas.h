@@ -0,0 +1,64 @@
+/*
+
+    This file is part of Dash Graphics Library
+    Copyright 2017 Benjamin Collins
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy of this
+    software and associated documentation files (the "Software"), to deal in the Software
+    without restriction, including without limitation the rights to use, copy, modify, merge,
+    publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+    to whom the Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all copies or
+    substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+    INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+    PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+    FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+    OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+*/
+
+#ifndef DASHGL_ATLAS
+#define DASHGL_ATLAS
+
+	/**********************************************************************/
+	/** Constants                                                        **/
+	/**********************************************************************/
+
+	#define DASH_ATLAS_MAX_ENTRIES 64
+	#define DASH_ATLAS_MAX_SIZE 2048
+	#define DASH_ATLAS_PADDING 1
+
+	/**********************************************************************/
+	/** Typedef                                                          **/
+	/**********************************************************************/
+
+	// One packed image. Position and size are in atlas pixels, the uv
+	// rect is the top-left and bottom-right corner in texture space.
+
+	typedef struct {
+		char name[64];
+		int x, y;
+		int width, height;
+		GLfloat uv[4];
+	} DashAtlasEntry;
+
+	typedef struct {
+		GLuint texture;
+		int width, height;
+		DashAtlasEntry entries[DASH_ATLAS_MAX_ENTRIES];
+		int num_entries;
+	} DashAtlas;
+
+	/**********************************************************************/
+	/** Texture Atlas                                                    **/
+	/**********************************************************************/
+
+	GLuint dash_atlas_build(DashAtlas *atlas, const char *directory);
+	DashAtlasEntry *dash_atlas_find(DashAtlas *atlas, const char *name);
+	void dash_atlas_free(DashAtlas *atlas);
+
+#endif
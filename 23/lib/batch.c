@@ -0,0 +1,293 @@
+/*
+    This file is part of Dash Graphics Library
+    Copyright 2017 Benjamin Collins
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy of this
+    software and associated documentation files (the "Software"), to deal in the Software
+    without restriction, including without limitation the rights to use, copy, modify, merge,
+    publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+    to whom the Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all copies or
+    substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+    INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+    PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+    FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+    OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <GL/glew.h>
+#include "dashgl.h"
+#include "batch.h"
+
+/******************************************************************************/
+/** Sprite Batch                                                             **/
+/******************************************************************************/
+
+static void dash_batch_pointers(DashBatch *batch, GLintptr offset) {
+
+	dash_bind_buffer(GL_ARRAY_BUFFER, batch->stream.buffer);
+
+	glVertexAttribPointer(
+		DASH_BATCH_TRANSFORM,
+		4,
+		GL_FLOAT,
+		GL_FALSE,
+		sizeof(DashSprite),
+		(void*)offset
+	);
+
+	glVertexAttribPointer(
+		DASH_BATCH_FRAME,
+		2,
+		GL_FLOAT,
+		GL_FALSE,
+		sizeof(DashSprite),
+		(void*)(offset + sizeof(float) * 4)
+	);
+
+}
+
+int dash_batch_init(DashBatch *batch, int capacity) {
+
+	int i;
+
+	// Unit quad shared by every instance, same winding as the per-sprite
+	// meshes it replaces. The shader scales it to the frame's size and
+	// maps the texture coordinates onto the frame's rectangle.
+
+	GLfloat quad_vertices[] = {
+		-0.5f, -0.5f, 0.0f, 0.0f,
+		-0.5f,  0.5f, 0.0f, 1.0f,
+		 0.5f,  0.5f, 1.0f, 1.0f,
+		 0.5f,  0.5f, 1.0f, 1.0f,
+		 0.5f, -0.5f, 1.0f, 0.0f,
+		-0.5f, -0.5f, 0.0f, 0.0f
+	};
+
+	memset(batch, 0, sizeof(DashBatch));
+	batch->capacity = capacity;
+
+	// The layout below is recorded once for every program, so each one
+	// has to be linked with the same locations
+
+	dash_program_attrib(DASH_BATCH_COORD2D, "coord2d");
+	dash_program_attrib(DASH_BATCH_TEXCOORD, "texcoord");
+	dash_program_attrib(DASH_BATCH_TRANSFORM, "sprite_transform");
+	dash_program_attrib(DASH_BATCH_FRAME, "sprite_frame");
+
+	glGenBuffers(1, &batch->quad_vbo);
+	dash_bind_buffer(GL_ARRAY_BUFFER, batch->quad_vbo);
+	glBufferData(
+		GL_ARRAY_BUFFER,
+		sizeof(quad_vertices),
+		quad_vertices,
+		GL_STATIC_DRAW
+	);
+
+	// Instances are written straight into a streaming ring, one region
+	// per frame in flight
+
+	if(!dash_stream_init(&batch->stream, capacity * sizeof(DashSprite))) {
+		return 0;
+	}
+
+	// Each region starts at a fixed offset, so the whole attribute
+	// layout can be recorded once per region and a draw only has to
+	// bind it
+
+	glGenVertexArrays(DASH_STREAM_FRAMES, batch->vao);
+
+	for(i = 0; i < DASH_STREAM_FRAMES; i++) {
+
+		dash_bind_vertex_array(batch->vao[i]);
+
+		dash_enable_attrib(DASH_BATCH_COORD2D);
+		dash_enable_attrib(DASH_BATCH_TEXCOORD);
+		dash_enable_attrib(DASH_BATCH_TRANSFORM);
+		dash_enable_attrib(DASH_BATCH_FRAME);
+
+		dash_bind_buffer(GL_ARRAY_BUFFER, batch->quad_vbo);
+		glVertexAttribPointer(
+			DASH_BATCH_COORD2D,
+			2,
+			GL_FLOAT,
+			GL_FALSE,
+			sizeof(float) * 4,
+			0
+		);
+
+		glVertexAttribPointer(
+			DASH_BATCH_TEXCOORD,
+			2,
+			GL_FLOAT,
+			GL_FALSE,
+			sizeof(float) * 4,
+			(void*)(sizeof(float) * 2)
+		);
+
+		dash_batch_pointers(batch, i * batch->stream.frame_size);
+
+		// Sprite data advances once per instance, the quad once per vertex
+
+		glVertexAttribDivisor(DASH_BATCH_TRANSFORM, 1);
+		glVertexAttribDivisor(DASH_BATCH_FRAME, 1);
+
+	}
+
+	dash_bind_vertex_array(0);
+	return 1;
+
+}
+
+int dash_batch_pinned(GLuint program) {
+
+	// Every program the batch draws with needs the locations bound in
+	// dash_batch_init. Only plain GL calls, so this is safe on a shared
+	// context in another thread.
+
+	if(glGetAttribLocation(program, "coord2d") != DASH_BATCH_COORD2D ||
+		glGetAttribLocation(program, "texcoord") != DASH_BATCH_TEXCOORD ||
+		glGetAttribLocation(program, "sprite_transform") != DASH_BATCH_TRANSFORM ||
+		glGetAttribLocation(program, "sprite_frame") != DASH_BATCH_FRAME) {
+		fprintf(stderr, "Program attribute locations do not match the batch\n");
+		return 0;
+	}
+
+	return 1;
+
+}
+
+int dash_batch_program(GLuint program) {
+
+	GLint uniform;
+
+	if(!dash_batch_pinned(program)) {
+		return 0;
+	}
+
+	// Sprites always sample from the first texture unit
+
+	uniform = glGetUniformLocation(program, "mytexture");
+	if(uniform == -1) {
+		fprintf(stderr, "Could not bind uniform %s\n", "mytexture");
+		return 0;
+	}
+
+	dash_use_program(program);
+	dash_uniform1i(uniform, 0);
+
+	return 1;
+
+}
+
+void dash_batch_begin(DashBatch *batch) {
+
+	GLintptr offset;
+
+	batch->count = 0;
+	batch->num_runs = 0;
+
+	// The batch is the only user of its stream, so the slab always
+	// starts at the beginning of the region the VAOs point at
+
+	batch->frame = batch->stream.frame;
+	dash_stream_begin(&batch->stream);
+	batch->sprites = (DashSprite*)dash_stream_alloc(
+		&batch->stream,
+		batch->capacity * sizeof(DashSprite),
+		&offset
+	);
+
+}
+
+DashSprite *dash_batch_push(DashBatch *batch, GLuint program, GLuint texture, unsigned int render) {
+
+	DashBatchRun *run;
+
+	if(batch->sprites == NULL || batch->count == batch->capacity) {
+		return NULL;
+	}
+
+	// Extend the current run while the state stays the same
+
+	run = batch->num_runs > 0 ? &batch->runs[batch->num_runs - 1] : NULL;
+
+	if(run == NULL || run->program != program || run->texture != texture || run->render != render) {
+
+		if(batch->num_runs == DASH_BATCH_MAX_RUNS) {
+			return NULL;
+		}
+
+		run = &batch->runs[batch->num_runs++];
+		run->program = program;
+		run->texture = texture;
+		run->render = render;
+		run->first = batch->count;
+		run->count = 0;
+
+	}
+
+	run->count++;
+	return &batch->sprites[batch->count++];
+
+}
+
+void dash_batch_draw(DashBatch *batch) {
+
+	int i;
+	GLintptr base;
+	DashBatchRun *run;
+
+	dash_stream_end(&batch->stream);
+	batch->sprites = NULL;
+
+	base = batch->frame * batch->stream.frame_size;
+	dash_active_texture(GL_TEXTURE0);
+	dash_bind_vertex_array(batch->vao[batch->frame]);
+
+	for(i = 0; i < batch->num_runs; i++) {
+
+		run = &batch->runs[i];
+
+		dash_render_state(run->render);
+		dash_use_program(run->program);
+		dash_bind_texture(GL_TEXTURE_2D, run->texture);
+
+		// Base instance lets the recorded layout address any run,
+		// otherwise the instance pointers are moved to the run
+
+		if(GLEW_ARB_base_instance) {
+			glDrawArraysInstancedBaseInstance(GL_TRIANGLES, 0, 6, run->count, run->first);
+			continue;
+		}
+
+		dash_batch_pointers(batch, base + run->first * sizeof(DashSprite));
+		glDrawArraysInstanced(GL_TRIANGLES, 0, 6, run->count);
+
+	}
+
+	dash_stream_fence(&batch->stream);
+
+}
+
+void dash_batch_free(DashBatch *batch) {
+
+	dash_bind_vertex_array(0);
+	dash_bind_buffer(GL_ARRAY_BUFFER, 0);
+
+	glDeleteVertexArrays(DASH_STREAM_FRAMES, batch->vao);
+	glDeleteBuffers(1, &batch->quad_vbo);
+	dash_stream_free(&batch->stream);
+
+}
+
+/******************************************************************************/
+/** End Program                                                              **/
+/******************************************************************************/
@@ -0,0 +1,94 @@
+/*
+
+    This file is part of Dash Graphics Library
+    Copyright 2017 Benjamin Collins
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy of this
+    software and associated documentation files (the "Software"), to deal in the Software
+    without restriction, including without limitation the rights to use, copy, modify, merge,
+    publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+    to whom the Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all copies or
+    substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+    INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+    PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+    FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+    OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+*/
+
+#ifndef DASHGL_BATCH
+#define DASHGL_BATCH
+
+	/**********************************************************************/
+	/** Constants                                                        **/
+	/**********************************************************************/
+
+	#define DASH_BATCH_MAX_RUNS 64
+
+	// Attribute locations bound into every sprite program, so one set of
+	// vertex array objects works with all of them
+
+	#define DASH_BATCH_COORD2D 0
+	#define DASH_BATCH_TEXCOORD 1
+	#define DASH_BATCH_TRANSFORM 2
+	#define DASH_BATCH_FRAME 3
+
+	/**********************************************************************/
+	/** Typedef                                                          **/
+	/**********************************************************************/
+
+	// One instance as it is laid out in the instance buffer. Position
+	// is the sprite center in world units, scale multiplies the frame's
+	// size and rotation is in radians. The frame indexes the animation
+	// frame table uploaded to the program, depth runs from 0 (front) to
+	// 1 (back) and only matters with depth testing.
+
+	typedef struct {
+		GLfloat pos[2];
+		GLfloat scale;
+		GLfloat rotation;
+		GLfloat frame;
+		GLfloat depth;
+	} DashSprite;
+
+	// A run is a range of consecutive instances drawn with the same
+	// program, texture and render state in a single instanced draw call.
+
+	typedef struct {
+		GLuint program;
+		GLuint texture;
+		unsigned int render;
+		int first;
+		int count;
+	} DashBatchRun;
+
+	typedef struct {
+		GLuint quad_vbo;
+		GLuint vao[DASH_STREAM_FRAMES];
+		DashStream stream;
+		DashSprite *sprites;
+		int frame;
+		int capacity;
+		int count;
+		DashBatchRun runs[DASH_BATCH_MAX_RUNS];
+		int num_runs;
+	} DashBatch;
+
+	/**********************************************************************/
+	/** Sprite Batch                                                     **/
+	/**********************************************************************/
+
+	int dash_batch_init(DashBatch *batch, int capacity);
+	int dash_batch_pinned(GLuint program);
+	int dash_batch_program(GLuint program);
+	void dash_batch_begin(DashBatch *batch);
+	DashSprite *dash_batch_push(DashBatch *batch, GLuint program, GLuint texture, unsigned int render);
+	void dash_batch_draw(DashBatch *batch);
+	void dash_batch_free(DashBatch *batch);
+
+#endif
@@ -0,0 +1,378 @@
+/*
+    This file is part of Dash Graphics Library
+    Copyright 2017 Benjamin Collins
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy of this
+    software and associated documentation files (the "Software"), to deal in the Software
+    without restriction, including without limitation the rights to use, copy, modify, merge,
+    publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+    to whom the Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all copies or
+    substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+    INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+    PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+    FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+    OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <GL/glew.h>
+#include "dashgl.h"
+#include "capture.h"
+
+/******************************************************************************/
+/** Writer Thread                                                            **/
+/******************************************************************************/
+
+// The render thread only queues reads and copies out finished buffers.
+// Color conversion, compression and file IO all happen here.
+
+static void dash_capture_y4m(DashCapture *capture, unsigned char *pixels) {
+
+	int x, y, w, h, i, r, g, b;
+	unsigned char *row, *p, *plane;
+
+	w = capture->width;
+	h = capture->height;
+	plane = (unsigned char*)malloc(w * h);
+	if(plane == NULL) {
+		return;
+	}
+
+	fprintf(capture->fp, "FRAME\n");
+
+	// Luma at full resolution, rows flipped since GL reads bottom up
+
+	for(y = 0; y < h; y++) {
+		row = &pixels[(h - 1 - y) * w * 4];
+		for(x = 0; x < w; x++) {
+			p = &row[x * 4];
+			plane[y * w + x] = (66 * p[0] + 129 * p[1] + 25 * p[2] + 128) / 256 + 16;
+		}
+	}
+
+	fwrite(plane, 1, w * h, capture->fp);
+
+	// Chroma from the average of each 2x2 block, Cb then Cr
+
+	for(i = 0; i < 2; i++) {
+
+		for(y = 0; y < h / 2; y++) {
+
+			for(x = 0; x < w / 2; x++) {
+
+				row = &pixels[(h - 2 - 2 * y) * w * 4 + x * 8];
+				r = (row[0] + row[4] + row[w * 4] + row[w * 4 + 4]) / 4;
+				g = (row[1] + row[5] + row[w * 4 + 1] + row[w * 4 + 5]) / 4;
+				b = (row[2] + row[6] + row[w * 4 + 2] + row[w * 4 + 6]) / 4;
+
+				if(i == 0) {
+					plane[y * (w / 2) + x] = (-38 * r - 74 * g + 112 * b + 128) / 256 + 128;
+				} else {
+					plane[y * (w / 2) + x] = (112 * r - 94 * g - 18 * b + 128) / 256 + 128;
+				}
+
+			}
+
+		}
+
+		fwrite(plane, 1, (w / 2) * (h / 2), capture->fp);
+
+	}
+
+	free(plane);
+
+}
+
+static void *dash_capture_writer(void *data) {
+
+	DashCapture *capture;
+	unsigned char *pixels;
+	unsigned long frame;
+	char filename[300];
+	int repeat;
+
+	capture = (DashCapture*)data;
+	frame = 0;
+
+	while(1) {
+
+		pthread_mutex_lock(&capture->lock);
+		while(capture->count == 0 && capture->running) {
+			pthread_cond_wait(&capture->cond, &capture->lock);
+		}
+
+		if(capture->count == 0) {
+			pthread_mutex_unlock(&capture->lock);
+			break;
+		}
+
+		pixels = capture->queue[capture->head];
+		repeat = capture->repeat[capture->head];
+		capture->head = (capture->head + 1) % DASH_CAPTURE_QUEUE;
+		capture->count--;
+		pthread_mutex_unlock(&capture->lock);
+
+		while(repeat-- > 0) {
+
+			if(capture->format == DASH_CAPTURE_Y4M) {
+				dash_capture_y4m(capture, pixels);
+			} else {
+				snprintf(filename, sizeof(filename), "%s%05lu.png", capture->path, frame);
+				dash_png_write(filename, capture->width, capture->height, pixels);
+			}
+
+			frame++;
+
+		}
+
+		free(pixels);
+
+	}
+
+	return NULL;
+
+}
+
+/******************************************************************************/
+/** Frame Capture                                                            **/
+/******************************************************************************/
+
+int dash_capture_start(DashCapture *capture, const char *path, int width, int height, int rate) {
+
+	int i;
+	size_t len;
+
+	memset(capture, 0, sizeof(DashCapture));
+	capture->width = width & ~1;
+	capture->height = height & ~1;
+
+	// A .y4m path is one video file, anything else is the start of a png
+	// name per frame. shots/frame or shots/frame.png both give
+	// shots/frame00000.png and on.
+
+	len = strlen(path);
+	if(len >= sizeof(capture->path)) {
+		fprintf(stderr, "Capture path too long\n");
+		return 0;
+	}
+
+	strcpy(capture->path, path);
+
+	if(len > 4 && strcmp(&path[len - 4], ".png") == 0) {
+		capture->path[len - 4] = '\0';
+	}
+
+	if(len > 4 && strcmp(&path[len - 4], ".y4m") == 0) {
+
+		capture->format = DASH_CAPTURE_Y4M;
+		capture->fp = fopen(path, "wb");
+		if(capture->fp == NULL) {
+			fprintf(stderr, "Could not open %s for writing\n", path);
+			return 0;
+		}
+
+		fprintf(
+			capture->fp,
+			"YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n",
+			capture->width,
+			capture->height,
+			rate
+		);
+
+	} else {
+		capture->format = DASH_CAPTURE_PNG;
+	}
+
+	glGenBuffers(DASH_CAPTURE_SLOTS, capture->pbo);
+
+	for(i = 0; i < DASH_CAPTURE_SLOTS; i++) {
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, capture->pbo[i]);
+		glBufferData(
+			GL_PIXEL_PACK_BUFFER,
+			capture->width * capture->height * 4,
+			NULL,
+			GL_STREAM_READ
+		);
+	}
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	pthread_mutex_init(&capture->lock, NULL);
+	pthread_cond_init(&capture->cond, NULL);
+	capture->running = 1;
+
+	if(pthread_create(&capture->thread, NULL, dash_capture_writer, capture) != 0) {
+		fprintf(stderr, "Could not start capture writer\n");
+		capture->running = 0;
+		dash_capture_stop(capture);
+		return 0;
+	}
+
+	return 1;
+
+}
+
+static int dash_capture_collect(DashCapture *capture, int wait) {
+
+	int slot, size, tail;
+	GLenum status;
+	unsigned char *mapped, *pixels;
+
+	// Oldest read still in flight
+
+	slot = (capture->slot + DASH_CAPTURE_SLOTS - capture->pending) % DASH_CAPTURE_SLOTS;
+
+	status = glClientWaitSync(
+		capture->fences[slot],
+		wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0,
+		wait ? 1000000000 : 0
+	);
+
+	if(status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+		return 0;
+	}
+
+	glDeleteSync(capture->fences[slot]);
+	capture->fences[slot] = NULL;
+	capture->pending--;
+
+	// The writer owns the copy, the slot is free again once it is made
+
+	size = capture->width * capture->height * 4;
+	pixels = (unsigned char*)malloc(size);
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, capture->pbo[slot]);
+	mapped = (unsigned char*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+
+	if(mapped != NULL && pixels != NULL) {
+		memcpy(pixels, mapped, size);
+	} else {
+		free(pixels);
+		pixels = NULL;
+	}
+
+	if(mapped != NULL) {
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	pthread_mutex_lock(&capture->lock);
+
+	// A frame that can't be kept is dropped, the one queued before it is
+	// shown for longer instead so the timing holds
+
+	if(pixels == NULL || capture->count == DASH_CAPTURE_QUEUE) {
+		capture->dropped++;
+		free(pixels);
+		if(capture->count > 0) {
+			tail = (capture->head + capture->count - 1) % DASH_CAPTURE_QUEUE;
+			capture->repeat[tail] += capture->copies[slot];
+			capture->frames += capture->copies[slot];
+		}
+	} else {
+		tail = (capture->head + capture->count) % DASH_CAPTURE_QUEUE;
+		capture->queue[tail] = pixels;
+		capture->repeat[tail] = capture->copies[slot];
+		capture->count++;
+		capture->frames += capture->copies[slot];
+		pthread_cond_signal(&capture->cond);
+	}
+
+	pthread_mutex_unlock(&capture->lock);
+	return 1;
+
+}
+
+void dash_capture_frame(DashCapture *capture, GLuint fbo, int copies) {
+
+	// Hand over every read that has landed. When all slots are busy the
+	// oldest is waited on; it was queued frames ago so this rarely blocks.
+	// The image is read once and written copies times.
+
+	while(capture->pending > 0) {
+		if(!dash_capture_collect(capture, capture->pending == DASH_CAPTURE_SLOTS)) {
+			break;
+		}
+	}
+
+	// With every slot still busy this read is skipped and its frames go
+	// to the next one
+
+	if(capture->pending == DASH_CAPTURE_SLOTS) {
+		capture->carry += copies;
+		capture->dropped++;
+		return;
+	}
+
+	// Queue this frame's read, it lands in the buffer without waiting
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, capture->pbo[capture->slot]);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(
+		0,
+		0,
+		capture->width,
+		capture->height,
+		GL_RGBA,
+		GL_UNSIGNED_BYTE,
+		0
+	);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	capture->fences[capture->slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	capture->copies[capture->slot] = copies + capture->carry;
+	capture->carry = 0;
+	capture->slot = (capture->slot + 1) % DASH_CAPTURE_SLOTS;
+	capture->pending++;
+
+}
+
+void dash_capture_stop(DashCapture *capture) {
+
+	int i;
+
+	while(capture->pending > 0) {
+		if(!dash_capture_collect(capture, 1)) {
+			break;
+		}
+	}
+
+	for(i = 0; i < DASH_CAPTURE_SLOTS; i++) {
+		if(capture->fences[i] != NULL) {
+			glDeleteSync(capture->fences[i]);
+		}
+	}
+
+	if(capture->running) {
+		pthread_mutex_lock(&capture->lock);
+		capture->running = 0;
+		pthread_cond_signal(&capture->cond);
+		pthread_mutex_unlock(&capture->lock);
+		pthread_join(capture->thread, NULL);
+	}
+
+	pthread_mutex_destroy(&capture->lock);
+	pthread_cond_destroy(&capture->cond);
+
+	glDeleteBuffers(DASH_CAPTURE_SLOTS, capture->pbo);
+
+	if(capture->fp != NULL) {
+		fclose(capture->fp);
+		capture->fp = NULL;
+	}
+
+}
+
+/******************************************************************************/
+/** End Program                                                              **/
+/******************************************************************************/
@@ -0,0 +1,79 @@
+/*
+
+    This file is part of Dash Graphics Library
+    Copyright 2017 Benjamin Collins
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy of this
+    software and associated documentation files (the "Software"), to deal in the Software
+    without restriction, including without limitation the rights to use, copy, modify, merge,
+    publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+    to whom the Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all copies or
+    substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+    INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+    PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+    FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+    OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+*/
+
+#ifndef DASHGL_CAPTURE
+#define DASHGL_CAPTURE
+
+	/**********************************************************************/
+	/** Constants                                                        **/
+	/**********************************************************************/
+
+	// Reads in flight on the GPU, and frames read back but not yet
+	// written. A full writer queue drops frames instead of stalling.
+
+	#define DASH_CAPTURE_SLOTS 3
+	#define DASH_CAPTURE_QUEUE 16
+
+	#define DASH_CAPTURE_Y4M 0
+	#define DASH_CAPTURE_PNG 1
+
+	/**********************************************************************/
+	/** Typedef                                                          **/
+	/**********************************************************************/
+
+	// Each read can stand for several frames of the output, so a
+	// stream keeps its declared rate however often it is read from
+
+	typedef struct {
+		GLuint pbo[DASH_CAPTURE_SLOTS];
+		GLsync fences[DASH_CAPTURE_SLOTS];
+		int copies[DASH_CAPTURE_SLOTS];
+		int slot;
+		int pending;
+		int carry;
+		int width;
+		int height;
+		int format;
+		char path[256];
+		FILE *fp;
+		unsigned long frames;
+		unsigned long dropped;
+		pthread_t thread;
+		pthread_mutex_t lock;
+		pthread_cond_t cond;
+		unsigned char *queue[DASH_CAPTURE_QUEUE];
+		int repeat[DASH_CAPTURE_QUEUE];
+		int head;
+		int count;
+		int running;
+	} DashCapture;
+
+	/**********************************************************************/
+	/** Frame Capture                                                    **/
+	/**********************************************************************/
+
+	int dash_capture_start(DashCapture *capture, const char *path, int width, int height, int rate);
+	void dash_capture_frame(DashCapture *capture, GLuint fbo, int copies);
+	void dash_capture_stop(DashCapture *capture);
+
+#endif
@@ -22,9 +22,16 @@
 #include <png.h>
 #include <math.h>
 #include <stdio.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/inotify.h>
 #include <GL/glew.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
 #include "dashgl.h"
 
 /******************************************************************************/
@@ -74,6 +81,394 @@ void vec3_normalize(vec3 a, vec3 v) {
 
 }
 
+/******************************************************************************/
+/** Program Cache                                                            **/
+/******************************************************************************/
+
+// Linked programs are saved with glGetProgramBinary under
+// $XDG_CACHE_HOME/dashgl, named by a hash of both sources and the driver
+// that built them. A binary the driver rejects is rebuilt from source and
+// stored again.
+
+#define DASH_CACHE_PATH 1024
+
+// Attribute locations bound before every link, the only way to fix them
+// for shaders that cannot declare them
+
+#define DASH_ATTRIB_MAX 16
+
+static struct {
+	int count;
+	GLuint index[DASH_ATTRIB_MAX];
+	const char *name[DASH_ATTRIB_MAX];
+} dash_attribs;
+
+static char *dash_read_file(const char *filename, long *length) {
+
+	FILE *fp;
+	long file_len;
+	char *source;
+
+	fp = fopen(filename, "rb");
+	if(!fp) {
+		fprintf(stderr, "Could not open %s for reading\n", filename);
+		return NULL;
+	}
+	
+	fseek(fp, 0, SEEK_END);
+	file_len = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+
+	source = (char*)malloc(file_len + 1);
+	fread(source, file_len, 1, fp);
+	fclose(fp);
+	source[file_len] = '\0';
+
+	if(length != NULL) {
+		*length = file_len;
+	}
+
+	return source;
+
+}
+
+static uint64_t dash_fnv1a(uint64_t hash, const char *data, size_t len) {
+
+	size_t i;
+
+	for(i = 0; i < len; i++) {
+		hash ^= (unsigned char)data[i];
+		hash *= 0x100000001b3ULL;
+	}
+
+	return hash;
+
+}
+
+static int dash_program_cache_path(const char *vertex, const char *fragment, char *path) {
+
+	const char *base, *parts[4];
+	char dir[DASH_CACHE_PATH];
+	char *sources[2], *slash;
+	long lengths[2];
+	uint64_t hash;
+	size_t length;
+	int i, len;
+
+	if(!GLEW_ARB_get_program_binary) {
+		return 0;
+	}
+
+	// Paths too long for the buffer go without a cache instead of being
+	// cut short
+
+	base = getenv("XDG_CACHE_HOME");
+	if(base != NULL && base[0] != '\0') {
+		len = snprintf(dir, sizeof(dir), "%s/dashgl", base);
+	} else if(getenv("HOME") != NULL) {
+		len = snprintf(dir, sizeof(dir), "%s/.cache/dashgl", getenv("HOME"));
+	} else {
+		return 0;
+	}
+
+	if(len < 0 || len >= (int)sizeof(dir)) {
+		return 0;
+	}
+
+	sources[0] = dash_read_file(vertex, &lengths[0]);
+	sources[1] = dash_read_file(fragment, &lengths[1]);
+
+	if(sources[0] == NULL || sources[1] == NULL) {
+		free(sources[0]);
+		free(sources[1]);
+		return 0;
+	}
+
+	// Each part is hashed with its terminator so moving text from one
+	// to the next still changes the key
+
+	parts[0] = (const char*)glGetString(GL_RENDERER);
+	parts[1] = (const char*)glGetString(GL_VERSION);
+	parts[2] = sources[0];
+	parts[3] = sources[1];
+
+	hash = 0xcbf29ce484222325ULL;
+	for(i = 0; i < 4; i++) {
+		if(parts[i] != NULL) {
+			length = i < 2 ? strlen(parts[i]) : (size_t)lengths[i - 2];
+			hash = dash_fnv1a(hash, parts[i], length + 1);
+		}
+	}
+
+	free(sources[0]);
+	free(sources[1]);
+
+	len = snprintf(path, DASH_CACHE_PATH, "%s/%016llx.bin", dir, (unsigned long long)hash);
+	if(len < 0 || len >= DASH_CACHE_PATH) {
+		return 0;
+	}
+
+	// The parent may not exist yet either
+
+	slash = strrchr(dir, '/');
+	*slash = '\0';
+	mkdir(dir, 0700);
+	*slash = '/';
+	mkdir(dir, 0700);
+
+	return 1;
+
+}
+
+static GLuint dash_program_cache_load(const char *path) {
+
+	FILE *fp;
+	long file_len;
+	GLenum format;
+	GLint link_ok;
+	GLuint program;
+	char *binary;
+
+	fp = fopen(path, "rb");
+	if(fp == NULL) {
+		return 0;
+	}
+
+	fseek(fp, 0, SEEK_END);
+	file_len = ftell(fp) - (long)sizeof(GLenum);
+	fseek(fp, 0, SEEK_SET);
+
+	if(file_len <= 0 || fread(&format, sizeof(GLenum), 1, fp) != 1) {
+		fclose(fp);
+		return 0;
+	}
+
+	binary = (char*)malloc(file_len);
+	if(fread(binary, file_len, 1, fp) != 1) {
+		free(binary);
+		fclose(fp);
+		return 0;
+	}
+
+	fclose(fp);
+
+	// Drivers refuse binaries from other builds, which only means
+	// compiling from source this time
+
+	program = glCreateProgram();
+	glProgramBinary(program, format, binary, file_len);
+	free(binary);
+
+	glGetProgramiv(program, GL_LINK_STATUS, &link_ok);
+	if(!link_ok) {
+		glDeleteProgram(program);
+		return 0;
+	}
+
+	return program;
+
+}
+
+static void dash_program_cache_store(GLuint program, const char *path) {
+
+	char temp[DASH_CACHE_PATH + 32];
+	GLint length;
+	GLenum format;
+	char *binary;
+	FILE *fp;
+
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if(length <= 0) {
+		return;
+	}
+
+	binary = (char*)malloc(length);
+	glGetProgramBinary(program, length, &length, &format, binary);
+
+	// Written beside the final name and renamed, so another instance
+	// never reads half a file. The process id keeps two instances
+	// storing the same pair off each other's temporary file, program
+	// names only differ within one process.
+
+	snprintf(temp, sizeof(temp), "%s.%ld.%u", path, (long)getpid(), (unsigned int)program);
+	fp = fopen(temp, "wb");
+	if(fp == NULL) {
+		free(binary);
+		return;
+	}
+
+	fwrite(&format, sizeof(GLenum), 1, fp);
+	fwrite(binary, length, 1, fp);
+	fclose(fp);
+	free(binary);
+
+	if(rename(temp, path) != 0) {
+		remove(temp);
+	}
+
+}
+
+void dash_program_cache_drop(const char *vertex, const char *fragment) {
+
+	char path[DASH_CACHE_PATH];
+
+	// For binaries that load but no longer suit the caller, so the next
+	// dash_create_program builds from source
+
+	if(dash_program_cache_path(vertex, fragment, path)) {
+		remove(path);
+	}
+
+}
+
+/******************************************************************************/
+/** Shader Watch                                                             **/
+/******************************************************************************/
+
+// Programs registered here are reported by dash_watch_wait when one of
+// their source files is saved. Directories are watched rather than files,
+// since editors often save by renaming a new file over the old one.
+
+#define DASH_WATCH_MAX 16
+
+static struct {
+	int fd;
+	int count;
+	int wd[DASH_WATCH_MAX][2];
+	char name[DASH_WATCH_MAX][2][128];
+} dash_watch = { .fd = -1 };
+
+int dash_watch_init() {
+
+	dash_watch.fd = inotify_init1(IN_CLOEXEC);
+	dash_watch.count = 0;
+
+	if(dash_watch.fd == -1) {
+		fprintf(stderr, "Could not start watching shaders\n");
+		return 0;
+	}
+
+	return 1;
+
+}
+
+int dash_watch_program(const char *vertex, const char *fragment) {
+
+	const char *files[2], *slash;
+	char dir[256];
+	int i, slot;
+
+	if(dash_watch.fd == -1 || dash_watch.count == DASH_WATCH_MAX) {
+		return -1;
+	}
+
+	slot = dash_watch.count;
+	files[0] = vertex;
+	files[1] = fragment;
+
+	for(i = 0; i < 2; i++) {
+
+		slash = strrchr(files[i], '/');
+
+		if(slash == NULL) {
+			strcpy(dir, ".");
+			slash = files[i] - 1;
+		} else {
+			snprintf(dir, sizeof(dir), "%.*s", (int)(slash - files[i]), files[i]);
+		}
+
+		// Watching the same directory again returns the same descriptor
+
+		dash_watch.wd[slot][i] = inotify_add_watch(
+			dash_watch.fd,
+			dir,
+			IN_CLOSE_WRITE | IN_MOVED_TO
+		);
+
+		if(dash_watch.wd[slot][i] == -1) {
+			fprintf(stderr, "Could not watch %s\n", dir);
+			return -1;
+		}
+
+		snprintf(dash_watch.name[slot][i], sizeof(dash_watch.name[slot][i]), "%s", slash + 1);
+
+	}
+
+	return dash_watch.count++;
+
+}
+
+int dash_watch_wait(int *slots, int max, int timeout) {
+
+	union {
+		struct inotify_event event;
+		char bytes[4096];
+	} buffer;
+
+	struct inotify_event *event;
+	struct pollfd pfd;
+	int changed[DASH_WATCH_MAX];
+	int i, k, n;
+	ssize_t len;
+	char *p;
+
+	pfd.fd = dash_watch.fd;
+	pfd.events = POLLIN;
+
+	if(dash_watch.fd == -1 || poll(&pfd, 1, timeout) <= 0) {
+		return 0;
+	}
+
+	memset(changed, 0, sizeof(changed));
+
+	// One save is a burst of events, keep reading until it goes quiet
+	// so the program is only rebuilt once
+
+	do {
+
+		len = read(dash_watch.fd, buffer.bytes, sizeof(buffer.bytes));
+
+		for(p = buffer.bytes; len > 0 && p < buffer.bytes + len; p += sizeof(struct inotify_event) + event->len) {
+
+			event = (struct inotify_event*)p;
+			if(event->len == 0) {
+				continue;
+			}
+
+			for(i = 0; i < dash_watch.count; i++) {
+				for(k = 0; k < 2; k++) {
+					if(dash_watch.wd[i][k] == event->wd && strcmp(dash_watch.name[i][k], event->name) == 0) {
+						changed[i] = 1;
+					}
+				}
+			}
+
+		}
+
+	} while(poll(&pfd, 1, 50) > 0);
+
+	n = 0;
+	for(i = 0; i < dash_watch.count && n < max; i++) {
+		if(changed[i]) {
+			slots[n++] = i;
+		}
+	}
+
+	return n;
+
+}
+
+void dash_watch_free() {
+
+	if(dash_watch.fd != -1) {
+		close(dash_watch.fd);
+	}
+
+	dash_watch.fd = -1;
+	dash_watch.count = 0;
+
+}
+
 /******************************************************************************/
 /** Shader Utils                                                             **/
 /******************************************************************************/
@@ -107,24 +502,12 @@ void dash_print_log(GLuint object) {
 
 GLuint dash_create_shader(const char *filename, GLenum type) {
 
-	FILE *fp;
-	int file_len;
 	char *source;
 
-	fp = fopen(filename, "rb");
-	if(!fp) {
-		fprintf(stderr, "Could not open %s for reading\n", filename);
+	source = dash_read_file(filename, NULL);
+	if(source == NULL) {
 		return 0;
 	}
-	
-	fseek(fp, 0, SEEK_END);
-	file_len = ftell(fp);
-	fseek(fp, 0, SEEK_SET);
-
-	source = (char*)malloc(file_len + 1);
-	fread(source, file_len, 1, fp);
-	fclose(fp);
-	source[file_len] = '\0';
 
 	const GLchar *sources[] = {
 		source
@@ -149,26 +532,80 @@ GLuint dash_create_shader(const char *filename, GLenum type) {
 
 }
 
+void dash_program_attrib(GLuint index, const char *name) {
+
+	// Bound on every program linked from source after this call. The
+	// name has to outlive the table.
+
+	if(dash_attribs.count == DASH_ATTRIB_MAX) {
+		fprintf(stderr, "Too many attribute bindings for %s\n", name);
+		return;
+	}
+
+	dash_attribs.index[dash_attribs.count] = index;
+	dash_attribs.name[dash_attribs.count] = name;
+	dash_attribs.count++;
+
+}
+
 GLuint dash_create_program(const char *vertex, const char *fragment) {
 
-	GLuint vs = dash_create_shader(vertex, GL_VERTEX_SHADER);
-	GLuint fs = dash_create_shader(fragment, GL_FRAGMENT_SHADER);
-	if(vs == 0 || fs == 0) {
+	char path[DASH_CACHE_PATH];
+	GLuint cached, vs, fs, program;
+	GLint link_ok;
+	int i, cache;
+
+	// A binary from an earlier run skips compiling and linking
+
+	cache = dash_program_cache_path(vertex, fragment, path);
+	if(cache) {
+		cached = dash_program_cache_load(path);
+		if(cached != 0) {
+			return cached;
+		}
+	}
+
+	vs = dash_create_shader(vertex, GL_VERTEX_SHADER);
+	if(vs == 0) {
+		return 0;
+	}
+
+	fs = dash_create_shader(fragment, GL_FRAGMENT_SHADER);
+	if(fs == 0) {
+		glDeleteShader(vs);
 		return 0;
 	}
 	
-	GLint link_ok;
-	
-	GLuint program = glCreateProgram();
+	program = glCreateProgram();
 	glAttachShader(program, vs);
 	glAttachShader(program, fs);
+	for(i = 0; i < dash_attribs.count; i++) {
+		glBindAttribLocation(program, dash_attribs.index[i], dash_attribs.name[i]);
+	}
+	if(GLEW_ARB_get_program_binary) {
+		glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
 	glLinkProgram(program);
+
+	// The linked program no longer needs its shaders, so they are freed
+	// now instead of when the program goes
+
+	glDetachShader(program, vs);
+	glDetachShader(program, fs);
+	glDeleteShader(vs);
+	glDeleteShader(fs);
+
 	glGetProgramiv(program, GL_LINK_STATUS, &link_ok);
 	if(!link_ok) {
 		fprintf(stderr, "Program Link Error: ");
 		dash_print_log(program);
+		glDeleteProgram(program);
 		return 0;
 	}
+
+	if(cache) {
+		dash_program_cache_store(program, path);
+	}
 	
 	return program;
 
@@ -177,11 +614,10 @@ GLuint dash_create_program(const char *vertex, const char *fragment) {
 
 
 
-GLuint dash_texture_load(const char *filename) {
+unsigned char *dash_png_read(const char *filename, int *w, int *h, GLenum *format) {
 
 	FILE *fp;
 	
-	GLuint texture_id;
 	png_structp png_ptr;
     png_infop info_ptr;
 	int width, height, bit_depth;
@@ -289,22 +725,902 @@ GLuint dash_texture_load(const char *filename) {
 	png_free(png_ptr, rows);
 	png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
 
-    glGenTextures(1, &texture_id);
-    glBindTexture(GL_TEXTURE_2D, texture_id);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexImage2D(GL_TEXTURE_2D,
-        0,
-        bit_depth,
-        width,
-        height,
-        0,
-        bit_depth,
-        GL_UNSIGNED_BYTE,
-        data
-    );
-	free(data);
+	*w = width;
+	*h = height;
+	*format = bit_depth;
+	return data;
 
-	return texture_id;
+}
+
+int dash_png_write(const char *filename, int w, int h, unsigned char *pixels) {
+
+	FILE *fp;
+	png_structp png_ptr;
+	png_infop info_ptr;
+	int y;
+
+	fp = fopen(filename, "wb");
+	if(fp == NULL) {
+		fprintf(stderr, "Could not open %s for writing\n", filename);
+		return 0;
+	}
+
+	png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+	if(png_ptr == NULL) {
+		fclose(fp);
+		return 0;
+	}
+
+	info_ptr = png_create_info_struct(png_ptr);
+	if(info_ptr == NULL) {
+		png_destroy_write_struct(&png_ptr, NULL);
+		fclose(fp);
+		return 0;
+	}
+
+	if(setjmp(png_jmpbuf(png_ptr))) {
+		png_destroy_write_struct(&png_ptr, &info_ptr);
+		fclose(fp);
+		return 0;
+	}
+
+	png_init_io(png_ptr, fp);
+	png_set_IHDR(
+		png_ptr,
+		info_ptr,
+		w,
+		h,
+		8,
+		PNG_COLOR_TYPE_RGBA,
+		PNG_INTERLACE_NONE,
+		PNG_COMPRESSION_TYPE_DEFAULT,
+		PNG_FILTER_TYPE_DEFAULT
+	);
+	png_write_info(png_ptr, info_ptr);
+
+	// Pixels come straight from glReadPixels, so the first row in memory
+	// is the bottom of the image
+
+	for(y = h - 1; y >= 0; y--) {
+		png_write_row(png_ptr, &pixels[y * w * 4]);
+	}
+
+	png_write_end(png_ptr, NULL);
+	png_destroy_write_struct(&png_ptr, &info_ptr);
+	fclose(fp);
+
+	return 1;
+
+}
+
+GLuint dash_texture_create(int width, int height, GLenum format, const unsigned char *data) {
+
+	GLuint texture_id, pbo;
+	GLenum internal_format;
+	GLsizeiptr size;
+	void *mapped;
+
+	internal_format = format == GL_RGBA ? GL_RGBA8 : GL_RGB8;
+	size = width * height * (format == GL_RGBA ? 4 : 3);
+
+	// Sprites are pixel art with a single level, set it up that way so
+	// the texture is complete without mipmaps and samples no neighbours
+
+	glGenTextures(1, &texture_id);
+	dash_bind_texture(GL_TEXTURE_2D, texture_id);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+
+	if(GLEW_ARB_texture_storage) {
+		glTexStorage2D(GL_TEXTURE_2D, 1, internal_format, width, height);
+	} else {
+		glTexImage2D(GL_TEXTURE_2D,
+			0,
+			internal_format,
+			width,
+			height,
+			0,
+			format,
+			GL_UNSIGNED_BYTE,
+			NULL
+		);
+	}
+
+	// Pixels go through an unpack buffer, so the copy into the texture
+	// is queued on the GPU and the caller can free its data and use the
+	// texture straight away. Deleting the buffer is deferred by GL until
+	// the copy is done.
+
+	glGenBuffers(1, &pbo);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+
+	mapped = glMapBufferRange(
+		GL_PIXEL_UNPACK_BUFFER,
+		0,
+		size,
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT
+	);
+
+	if(mapped != NULL) {
+		memcpy(mapped, data, size);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+	} else {
+		glBufferSubData(GL_PIXEL_UNPACK_BUFFER, 0, size, data);
+	}
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexSubImage2D(GL_TEXTURE_2D,
+		0,
+		0,
+		0,
+		width,
+		height,
+		format,
+		GL_UNSIGNED_BYTE,
+		0
+	);
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	glDeleteBuffers(1, &pbo);
+
+	return texture_id;
+
+}
+
+GLuint dash_texture_load(const char *filename) {
+
+	GLuint texture_id;
+	int width, height;
+	GLenum format;
+	unsigned char *data;
+
+	data = dash_png_read(filename, &width, &height, &format);
+	if(data == NULL) {
+		return 0;
+	}
+
+	texture_id = dash_texture_create(width, height, format, data);
+	free(data);
+
+	return texture_id;
+
+}
+
+/******************************************************************************/
+/** State Cache                                                              **/
+/******************************************************************************/
+
+// Shadow copy of the GL state the renderer touches every frame. Calls that
+// would not change anything are dropped before they reach the driver. Any
+// code that changes this state behind the cache's back has to call
+// dash_state_reset() afterwards.
+
+#define DASH_STATE_MAX_UNITS 32
+#define DASH_STATE_MAX_ATTRIBS 32
+#define DASH_STATE_MAX_UNIFORMS 256
+
+typedef struct {
+	GLuint program;
+	GLint location;
+	GLfloat value[4];
+} DashUniformSlot;
+
+static struct {
+	int valid;
+	GLuint program;
+	GLuint array_buffer;
+	GLuint vertex_array;
+	GLenum active_texture;
+	GLuint texture[DASH_STATE_MAX_UNITS];
+	unsigned int attribs;
+	unsigned int attribs_known;
+	unsigned int render;
+	DashUniformSlot uniforms[DASH_STATE_MAX_UNIFORMS];
+	unsigned long issued;
+	unsigned long skipped;
+} dash_state;
+
+void dash_state_reset() {
+
+	int i;
+
+	dash_state.valid = 1;
+	dash_state.program = 0;
+	dash_state.array_buffer = 0;
+	dash_state.vertex_array = 0;
+	dash_state.active_texture = GL_TEXTURE0;
+	dash_state.attribs = 0;
+	dash_state.attribs_known = 0;
+	dash_state.render = DASH_DEPTH_WRITE;
+
+	for(i = 0; i < DASH_STATE_MAX_UNITS; i++) {
+		dash_state.texture[i] = 0;
+	}
+
+	// Location -1 marks an empty slot, glUniform ignores it anyway
+
+	for(i = 0; i < DASH_STATE_MAX_UNIFORMS; i++) {
+		dash_state.uniforms[i].program = 0;
+		dash_state.uniforms[i].location = -1;
+	}
+
+	// Put the driver in the state the cache now assumes
+
+	glUseProgram(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+	glActiveTexture(GL_TEXTURE0);
+	glDisable(GL_DEPTH_TEST);
+	glDepthMask(GL_TRUE);
+	glDisable(GL_BLEND);
+
+}
+
+static int dash_state_skip(int same) {
+
+	if(!dash_state.valid) {
+		dash_state_reset();
+		same = 0;
+	}
+
+	if(same) {
+		dash_state.skipped++;
+	} else {
+		dash_state.issued++;
+	}
+
+	return same;
+
+}
+
+static DashUniformSlot *dash_state_uniform(GLint location, GLsizei count, const GLfloat *value, int *same) {
+
+	DashUniformSlot *slot;
+	unsigned int hash;
+	int i;
+
+	if(!dash_state.valid) {
+		dash_state_reset();
+	}
+
+	hash = (dash_state.program * 31u + (unsigned int)location) % DASH_STATE_MAX_UNIFORMS;
+
+	for(i = 0; i < DASH_STATE_MAX_UNIFORMS; i++) {
+
+		slot = &dash_state.uniforms[(hash + i) % DASH_STATE_MAX_UNIFORMS];
+
+		if(slot->location == -1) {
+			slot->program = dash_state.program;
+			slot->location = location;
+			*same = 0;
+			return slot;
+		}
+
+		if(slot->program == dash_state.program && slot->location == location) {
+			*same = memcmp(slot->value, value, count * sizeof(GLfloat)) == 0;
+			return slot;
+		}
+
+	}
+
+	// Table full, nothing can be cached
+
+	*same = 0;
+	return NULL;
+
+}
+
+void dash_use_program(GLuint program) {
+
+	if(dash_state_skip(dash_state.program == program)) {
+		return;
+	}
+
+	dash_state.program = program;
+	glUseProgram(program);
+
+}
+
+void dash_bind_buffer(GLenum target, GLuint buffer) {
+
+	// Only the array buffer is global, the element buffer belongs to the
+	// vertex array and the rest are rarely rebound
+
+	if(target != GL_ARRAY_BUFFER) {
+		dash_state.issued++;
+		glBindBuffer(target, buffer);
+		return;
+	}
+
+	if(dash_state_skip(dash_state.array_buffer == buffer)) {
+		return;
+	}
+
+	dash_state.array_buffer = buffer;
+	glBindBuffer(target, buffer);
+
+}
+
+void dash_bind_vertex_array(GLuint vertex_array) {
+
+	if(dash_state_skip(dash_state.vertex_array == vertex_array)) {
+		return;
+	}
+
+	// Enabled arrays are part of the vertex array object, so whatever
+	// was cached for the previous one no longer applies
+
+	dash_state.vertex_array = vertex_array;
+	dash_state.attribs_known = 0;
+	glBindVertexArray(vertex_array);
+
+}
+
+void dash_active_texture(GLenum unit) {
+
+	if(dash_state_skip(dash_state.active_texture == unit)) {
+		return;
+	}
+
+	dash_state.active_texture = unit;
+	glActiveTexture(unit);
+
+}
+
+void dash_bind_texture(GLenum target, GLuint texture) {
+
+	GLuint *bound;
+
+	bound = &dash_state.texture[(dash_state.active_texture - GL_TEXTURE0) % DASH_STATE_MAX_UNITS];
+
+	if(target != GL_TEXTURE_2D) {
+		dash_state.issued++;
+		glBindTexture(target, texture);
+		return;
+	}
+
+	if(dash_state_skip(*bound == texture)) {
+		return;
+	}
+
+	*bound = texture;
+	glBindTexture(target, texture);
+
+}
+
+void dash_uniform1i(GLint location, GLint v) {
+
+	DashUniformSlot *slot;
+	GLfloat value;
+	int same;
+
+	// Sampler and integer uniforms are stored as floats, which is exact
+	// for the small values they hold
+
+	value = (GLfloat)v;
+	slot = dash_state_uniform(location, 1, &value, &same);
+
+	if(dash_state_skip(same)) {
+		return;
+	}
+
+	if(slot != NULL) {
+		slot->value[0] = value;
+	}
+
+	glUniform1i(location, v);
+
+}
+
+void dash_uniform4fv(GLint location, const GLfloat *v) {
+
+	DashUniformSlot *slot;
+	int same;
+
+	slot = dash_state_uniform(location, 4, v, &same);
+
+	if(dash_state_skip(same)) {
+		return;
+	}
+
+	if(slot != NULL) {
+		memcpy(slot->value, v, 4 * sizeof(GLfloat));
+	}
+
+	glUniform4fv(location, 1, v);
+
+}
+
+void dash_enable_attrib(GLuint index) {
+
+	unsigned int bit = 1u << (index % DASH_STATE_MAX_ATTRIBS);
+
+	if(dash_state_skip((dash_state.attribs_known & dash_state.attribs & bit) != 0)) {
+		return;
+	}
+
+	dash_state.attribs |= bit;
+	dash_state.attribs_known |= bit;
+	glEnableVertexAttribArray(index);
+
+}
+
+void dash_render_state(unsigned int render) {
+
+	unsigned int changed;
+
+	if(!dash_state.valid) {
+		dash_state_reset();
+	}
+
+	changed = dash_state.render ^ render;
+
+	if(!dash_state_skip(!(changed & DASH_DEPTH_TEST))) {
+		if(render & DASH_DEPTH_TEST) {
+			glEnable(GL_DEPTH_TEST);
+		} else {
+			glDisable(GL_DEPTH_TEST);
+		}
+	}
+
+	if(!dash_state_skip(!(changed & DASH_DEPTH_WRITE))) {
+		glDepthMask(render & DASH_DEPTH_WRITE ? GL_TRUE : GL_FALSE);
+	}
+
+	if(!dash_state_skip(!(changed & DASH_BLEND))) {
+		if(render & DASH_BLEND) {
+			glEnable(GL_BLEND);
+		} else {
+			glDisable(GL_BLEND);
+		}
+	}
+
+	dash_state.render = render;
+
+}
+
+void dash_state_forget_program(GLuint program) {
+
+	int i;
+
+	// Program names are reused once deleted, so values cached for an
+	// old program must not be taken for the new one's
+
+	for(i = 0; i < DASH_STATE_MAX_UNIFORMS; i++) {
+		if(dash_state.uniforms[i].program == program) {
+			dash_state.uniforms[i].program = 0;
+			dash_state.uniforms[i].location = -1;
+		}
+	}
+
+}
+
+void dash_state_counters(unsigned long *issued, unsigned long *skipped) {
+
+	*issued = dash_state.issued;
+	*skipped = dash_state.skipped;
+
+}
+
+/******************************************************************************/
+/** Streaming Buffer                                                         **/
+/******************************************************************************/
+
+// With ARB_buffer_storage the whole ring is mapped once and stays mapped,
+// and the fence on each region keeps the CPU from writing where the GPU
+// is still reading. Without it every region is mapped unsynchronized for
+// the frame, and the buffer is orphaned each time the ring wraps so the
+// driver hands back fresh storage instead of waiting.
+
+int dash_stream_init(DashStream *stream, GLsizeiptr frame_size) {
+
+	GLbitfield flags;
+
+	memset(stream, 0, sizeof(DashStream));
+	stream->frame_size = frame_size;
+	stream->persistent = GLEW_ARB_buffer_storage ? 1 : 0;
+
+	glGenBuffers(1, &stream->buffer);
+	dash_bind_buffer(GL_ARRAY_BUFFER, stream->buffer);
+
+	if(!stream->persistent) {
+		glBufferData(
+			GL_ARRAY_BUFFER,
+			frame_size * DASH_STREAM_FRAMES,
+			NULL,
+			GL_STREAM_DRAW
+		);
+		return 1;
+	}
+
+	flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glBufferStorage(GL_ARRAY_BUFFER, frame_size * DASH_STREAM_FRAMES, NULL, flags);
+	stream->mapped = (unsigned char*)glMapBufferRange(
+		GL_ARRAY_BUFFER,
+		0,
+		frame_size * DASH_STREAM_FRAMES,
+		flags
+	);
+
+	if(stream->mapped == NULL) {
+		fprintf(stderr, "Could not map streaming buffer\n");
+		return 0;
+	}
+
+	return 1;
+
+}
+
+void *dash_stream_begin(DashStream *stream) {
+
+	GLenum wait;
+	GLsync fence;
+
+	stream->used = 0;
+
+	if(stream->persistent) {
+
+		fence = stream->fences[stream->frame];
+
+		if(fence != NULL) {
+
+			wait = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+			while(wait == GL_TIMEOUT_EXPIRED) {
+				wait = glClientWaitSync(fence, 0, 1000000);
+			}
+
+			glDeleteSync(fence);
+			stream->fences[stream->frame] = NULL;
+
+		}
+
+		stream->region = stream->mapped + stream->frame * stream->frame_size;
+		return stream->region;
+
+	}
+
+	dash_bind_buffer(GL_ARRAY_BUFFER, stream->buffer);
+
+	if(stream->frame == 0) {
+		glBufferData(
+			GL_ARRAY_BUFFER,
+			stream->frame_size * DASH_STREAM_FRAMES,
+			NULL,
+			GL_STREAM_DRAW
+		);
+	}
+
+	stream->region = (unsigned char*)glMapBufferRange(
+		GL_ARRAY_BUFFER,
+		stream->frame * stream->frame_size,
+		stream->frame_size,
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT
+	);
+
+	return stream->region;
+
+}
+
+void *dash_stream_alloc(DashStream *stream, GLsizeiptr size, GLintptr *offset) {
+
+	GLsizeiptr start;
+
+	// Keep every allocation aligned for vec4 attributes
+
+	start = (stream->used + 15) & ~(GLsizeiptr)15;
+	if(stream->region == NULL || start + size > stream->frame_size) {
+		return NULL;
+	}
+
+	stream->used = start + size;
+	*offset = stream->frame * stream->frame_size + start;
+	return stream->region + start;
+
+}
+
+void dash_stream_end(DashStream *stream) {
+
+	// Writes are done, a temporary mapping has to go before drawing
+
+	if(!stream->persistent && stream->region != NULL) {
+		dash_bind_buffer(GL_ARRAY_BUFFER, stream->buffer);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+	}
+
+	stream->region = NULL;
+
+}
+
+void dash_stream_fence(DashStream *stream) {
+
+	// Called after the last draw reading this frame's region
+
+	if(stream->persistent) {
+		stream->fences[stream->frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+
+	stream->frame = (stream->frame + 1) % DASH_STREAM_FRAMES;
+
+}
+
+void dash_stream_free(DashStream *stream) {
+
+	int i;
+
+	for(i = 0; i < DASH_STREAM_FRAMES; i++) {
+		if(stream->fences[i] != NULL) {
+			glDeleteSync(stream->fences[i]);
+		}
+	}
+
+	dash_bind_buffer(GL_ARRAY_BUFFER, stream->buffer);
+	if(stream->persistent) {
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+	}
+
+	dash_bind_buffer(GL_ARRAY_BUFFER, 0);
+	glDeleteBuffers(1, &stream->buffer);
+
+}
+
+/******************************************************************************/
+/** Render Target                                                            **/
+/******************************************************************************/
+
+int dash_target_init(DashTarget *target, int width, int height) {
+
+	GLenum status;
+
+	memset(target, 0, sizeof(DashTarget));
+	target->width = width;
+	target->height = height;
+
+	glGenRenderbuffers(1, &target->color);
+	glBindRenderbuffer(GL_RENDERBUFFER, target->color);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+	glGenRenderbuffers(1, &target->depth);
+	glBindRenderbuffer(GL_RENDERBUFFER, target->depth);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+
+	glGenFramebuffers(1, &target->fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, target->fbo);
+	glFramebufferRenderbuffer(
+		GL_FRAMEBUFFER,
+		GL_COLOR_ATTACHMENT0,
+		GL_RENDERBUFFER,
+		target->color
+	);
+	glFramebufferRenderbuffer(
+		GL_FRAMEBUFFER,
+		GL_DEPTH_ATTACHMENT,
+		GL_RENDERBUFFER,
+		target->depth
+	);
+
+	status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	if(status != GL_FRAMEBUFFER_COMPLETE) {
+		fprintf(stderr, "Framebuffer incomplete: 0x%x\n", status);
+		dash_target_free(target);
+		return 0;
+	}
+
+	return 1;
+
+}
+
+void dash_target_bind(DashTarget *target) {
+
+	glBindFramebuffer(GL_FRAMEBUFFER, target->fbo);
+	glViewport(0, 0, target->width, target->height);
+
+}
+
+void dash_target_blit(DashTarget *target, GLuint fbo, int width, int height, GLenum filter) {
+
+	int scale, w, h, x, y;
+
+	// Nearest filtering keeps pixels square by using the largest whole
+	// multiple that fits, linear filtering fills as much as the aspect
+	// ratio allows. Either way the rest is letterboxed.
+
+	scale = width / target->width;
+	if(height / target->height < scale) {
+		scale = height / target->height;
+	}
+
+	if(filter == GL_NEAREST && scale > 0) {
+		w = target->width * scale;
+		h = target->height * scale;
+	} else if(width * target->height < height * target->width) {
+		w = width;
+		h = width * target->height / target->width;
+	} else {
+		w = height * target->width / target->height;
+		h = height;
+	}
+
+	x = (width - w) / 2;
+	y = (height - h) / 2;
+
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo);
+	glViewport(0, 0, width, height);
+	glClear(GL_COLOR_BUFFER_BIT);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, target->fbo);
+	glBlitFramebuffer(
+		0,
+		0,
+		target->width,
+		target->height,
+		x,
+		y,
+		x + w,
+		y + h,
+		GL_COLOR_BUFFER_BIT,
+		filter
+	);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+
+}
+
+void dash_target_free(DashTarget *target) {
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDeleteFramebuffers(1, &target->fbo);
+	glDeleteRenderbuffers(1, &target->color);
+	glDeleteRenderbuffers(1, &target->depth);
+
+}
+
+/******************************************************************************/
+/** Headless Context                                                         **/
+/******************************************************************************/
+
+// A window-less GL context from Mesa's surfaceless EGL platform, which runs
+// on llvmpipe when there is no GPU. Nothing is ever presented, the frame is
+// drawn into a framebuffer object and read back with dash_headless_dump.
+
+int dash_headless_init(DashHeadless *headless, int width, int height) {
+
+	const char *extensions;
+	PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display;
+	EGLDisplay display;
+	EGLContext context;
+	EGLConfig config;
+	EGLint num_configs;
+
+	// Surfaceless displays only offer pbuffer configs, the default of
+	// window surfaces would match nothing
+
+	const EGLint config_attribs[] = {
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_NONE
+	};
+
+	const EGLint context_attribs[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 3,
+		EGL_CONTEXT_MINOR_VERSION, 3,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+
+	memset(headless, 0, sizeof(DashHeadless));
+
+	extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+	if(extensions == NULL || strstr(extensions, "EGL_MESA_platform_surfaceless") == NULL) {
+		fprintf(stderr, "EGL_MESA_platform_surfaceless is not supported\n");
+		return 0;
+	}
+
+	get_platform_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress(
+		"eglGetPlatformDisplayEXT"
+	);
+	if(get_platform_display == NULL) {
+		fprintf(stderr, "Could not load eglGetPlatformDisplayEXT\n");
+		return 0;
+	}
+
+	display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+	if(display == EGL_NO_DISPLAY || !eglInitialize(display, NULL, NULL)) {
+		fprintf(stderr, "Could not initialize EGL display\n");
+		return 0;
+	}
+
+	if(!eglBindAPI(EGL_OPENGL_API)) {
+		fprintf(stderr, "Desktop OpenGL is not available through EGL\n");
+		eglTerminate(display);
+		return 0;
+	}
+
+	if(!eglChooseConfig(display, config_attribs, &config, 1, &num_configs) || num_configs == 0) {
+		fprintf(stderr, "No EGL config for desktop OpenGL\n");
+		eglTerminate(display);
+		return 0;
+	}
+
+	context = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attribs);
+	if(context == EGL_NO_CONTEXT) {
+		fprintf(stderr, "Could not create EGL context\n");
+		eglTerminate(display);
+		return 0;
+	}
+
+	if(!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+		fprintf(stderr, "Could not make EGL context current\n");
+		eglDestroyContext(display, context);
+		eglTerminate(display);
+		return 0;
+	}
+
+	headless->display = display;
+	headless->context = context;
+
+	glewExperimental = GL_TRUE;
+	glewInit();
+
+	// Color and depth targets the size of the window it stands in for
+
+	if(!dash_target_init(&headless->target, width, height)) {
+		dash_headless_free(headless);
+		return 0;
+	}
+
+	dash_target_bind(&headless->target);
+	return 1;
+
+}
+
+int dash_headless_dump(DashHeadless *headless, const char *filename) {
+
+	DashTarget *target;
+	unsigned char *pixels;
+	int ok;
+
+	target = &headless->target;
+	pixels = (unsigned char*)malloc(target->width * target->height * 4);
+	if(pixels == NULL) {
+		return 0;
+	}
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, target->fbo);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(
+		0,
+		0,
+		target->width,
+		target->height,
+		GL_RGBA,
+		GL_UNSIGNED_BYTE,
+		pixels
+	);
+
+	ok = dash_png_write(filename, target->width, target->height, pixels);
+	free(pixels);
+
+	return ok;
+
+}
+
+void dash_headless_free(DashHeadless *headless) {
+
+	if(headless->context == NULL) {
+		return;
+	}
+
+	dash_target_free(&headless->target);
+
+	eglMakeCurrent(headless->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	eglDestroyContext(headless->display, headless->context);
+	eglTerminate(headless->display);
+
+	headless->context = NULL;
 
 }
 
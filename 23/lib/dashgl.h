@@ -31,6 +31,42 @@
 	typedef float mat4[16];
 	typedef float vec3[3];
 
+	// Ring of per-frame regions in one vertex buffer. Each region is
+	// fenced when the frame is submitted and waited on before reuse.
+
+	#define DASH_STREAM_FRAMES 3
+
+	typedef struct {
+		GLuint buffer;
+		GLsizeiptr frame_size;
+		int persistent;
+		int frame;
+		GLsizeiptr used;
+		unsigned char *mapped;
+		unsigned char *region;
+		GLsync fences[DASH_STREAM_FRAMES];
+	} DashStream;
+
+	// Fixed size color and depth framebuffer the scene is drawn into
+	// before it is scaled onto the real one
+
+	typedef struct {
+		GLuint fbo;
+		GLuint color;
+		GLuint depth;
+		int width;
+		int height;
+	} DashTarget;
+
+	// Window-less context drawing into a target. The EGL display and
+	// context are kept as plain pointers so includers don't need EGL.
+
+	typedef struct {
+		void *display;
+		void *context;
+		DashTarget target;
+	} DashHeadless;
+
 	/**********************************************************************/
 	/** Constants                                                        **/	
 	/**********************************************************************/
@@ -52,15 +88,80 @@
 	#define M_23 14
 	#define M_33 15
 
+	// Fixed function state bits for dash_render_state
+
+	#define DASH_DEPTH_TEST 1
+	#define DASH_DEPTH_WRITE 2
+	#define DASH_BLEND 4
+
 	/**********************************************************************/
 	/** Shader Utilities                                                 **/	
 	/**********************************************************************/
 
 	GLuint dash_create_shader(const char *filename, GLenum type);
 	void dash_print_log(GLuint object);
+	void dash_program_attrib(GLuint index, const char *name);
 	GLuint dash_create_program(const char *vertex, const char *fragment);
+	void dash_program_cache_drop(const char *vertex, const char *fragment);
+	unsigned char *dash_png_read(const char *filename, int *w, int *h, GLenum *format);
+	int dash_png_write(const char *filename, int w, int h, unsigned char *pixels);
+	GLuint dash_texture_create(int width, int height, GLenum format, const unsigned char *data);
 	GLuint dash_texture_load(const char *filename);
 	
+	/**********************************************************************/
+	/** Shader Watch                                                     **/	
+	/**********************************************************************/
+
+	int dash_watch_init();
+	int dash_watch_program(const char *vertex, const char *fragment);
+	int dash_watch_wait(int *slots, int max, int timeout);
+	void dash_watch_free();
+
+	/**********************************************************************/
+	/** State Cache                                                      **/	
+	/**********************************************************************/
+
+	void dash_state_reset();
+	void dash_use_program(GLuint program);
+	void dash_bind_buffer(GLenum target, GLuint buffer);
+	void dash_bind_vertex_array(GLuint vertex_array);
+	void dash_active_texture(GLenum unit);
+	void dash_bind_texture(GLenum target, GLuint texture);
+	void dash_uniform1i(GLint location, GLint v);
+	void dash_uniform4fv(GLint location, const GLfloat *v);
+	void dash_enable_attrib(GLuint index);
+	void dash_render_state(unsigned int render);
+	void dash_state_forget_program(GLuint program);
+	void dash_state_counters(unsigned long *issued, unsigned long *skipped);
+
+	/**********************************************************************/
+	/** Streaming Buffer                                                 **/	
+	/**********************************************************************/
+
+	int dash_stream_init(DashStream *stream, GLsizeiptr frame_size);
+	void *dash_stream_begin(DashStream *stream);
+	void *dash_stream_alloc(DashStream *stream, GLsizeiptr size, GLintptr *offset);
+	void dash_stream_end(DashStream *stream);
+	void dash_stream_fence(DashStream *stream);
+	void dash_stream_free(DashStream *stream);
+
+	/**********************************************************************/
+	/** Render Target                                                    **/	
+	/**********************************************************************/
+
+	int dash_target_init(DashTarget *target, int width, int height);
+	void dash_target_bind(DashTarget *target);
+	void dash_target_blit(DashTarget *target, GLuint fbo, int width, int height, GLenum filter);
+	void dash_target_free(DashTarget *target);
+
+	/**********************************************************************/
+	/** Headless Context                                                 **/	
+	/**********************************************************************/
+
+	int dash_headless_init(DashHeadless *headless, int width, int height);
+	int dash_headless_dump(DashHeadless *headless, const char *filename);
+	void dash_headless_free(DashHeadless *headless);
+
 	/**********************************************************************/
 	/** Vector3 Utilities                                                **/	
 	/**********************************************************************/
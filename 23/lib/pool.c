@@ -0,0 +1,137 @@
+/*
+    This file is part of Dash Graphics Library
+    Copyright 2017 Benjamin Collins
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy of this
+    software and associated documentation files (the "Software"), to deal in the Software
+    without restriction, including without limitation the rights to use, copy, modify, merge,
+    publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+    to whom the Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all copies or
+    substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+    INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+    PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+    FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+    OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+*/
+#include <stdlib.h>
+#include <string.h>
+#include "pool.h"
+
+/******************************************************************************/
+/** Component Pool                                                           **/
+/******************************************************************************/
+
+int dash_pool_init(DashPool *pool, int capacity) {
+
+	memset(pool, 0, sizeof(DashPool));
+
+	pool->x = (float*)malloc(capacity * sizeof(float));
+	pool->y = (float*)malloc(capacity * sizeof(float));
+	pool->prev_x = (float*)malloc(capacity * sizeof(float));
+	pool->prev_y = (float*)malloc(capacity * sizeof(float));
+	pool->vx = (float*)malloc(capacity * sizeof(float));
+	pool->vy = (float*)malloc(capacity * sizeof(float));
+	pool->tick = (int*)malloc(capacity * sizeof(int));
+	pool->flags = (unsigned int*)malloc(capacity * sizeof(unsigned int));
+
+	if(!pool->x || !pool->y || !pool->prev_x || !pool->prev_y ||
+		!pool->vx || !pool->vy || !pool->tick || !pool->flags) {
+		dash_pool_free(pool);
+		return 0;
+	}
+
+	pool->capacity = capacity;
+	return 1;
+
+}
+
+int dash_pool_spawn(DashPool *pool, float x, float y, float vx, float vy) {
+
+	int i;
+
+	if(pool->count == pool->capacity) {
+		return -1;
+	}
+
+	// A new entity has nowhere to move from yet
+
+	i = pool->count++;
+	pool->x[i] = x;
+	pool->y[i] = y;
+	pool->prev_x[i] = x;
+	pool->prev_y[i] = y;
+	pool->vx[i] = vx;
+	pool->vy[i] = vy;
+	pool->tick[i] = 0;
+	pool->flags[i] = 0;
+
+	return i;
+
+}
+
+void dash_pool_kill(DashPool *pool, int index) {
+
+	int last;
+
+	// Move the last entity into the hole. Loops that kill as they go
+	// should run backwards so the moved one has already been visited.
+
+	last = --pool->count;
+
+	if(index == last) {
+		return;
+	}
+
+	pool->x[index] = pool->x[last];
+	pool->y[index] = pool->y[last];
+	pool->prev_x[index] = pool->prev_x[last];
+	pool->prev_y[index] = pool->prev_y[last];
+	pool->vx[index] = pool->vx[last];
+	pool->vy[index] = pool->vy[last];
+	pool->tick[index] = pool->tick[last];
+	pool->flags[index] = pool->flags[last];
+
+}
+
+void dash_pool_remember(DashPool *pool) {
+
+	memcpy(pool->prev_x, pool->x, pool->count * sizeof(float));
+	memcpy(pool->prev_y, pool->y, pool->count * sizeof(float));
+
+}
+
+void dash_pool_move(DashPool *pool) {
+
+	int i;
+
+	for(i = 0; i < pool->count; i++) {
+		pool->x[i] += pool->vx[i];
+		pool->y[i] += pool->vy[i];
+	}
+
+}
+
+void dash_pool_free(DashPool *pool) {
+
+	free(pool->x);
+	free(pool->y);
+	free(pool->prev_x);
+	free(pool->prev_y);
+	free(pool->vx);
+	free(pool->vy);
+	free(pool->tick);
+	free(pool->flags);
+
+	memset(pool, 0, sizeof(DashPool));
+
+}
+
+/******************************************************************************/
+/** End Program                                                              **/
+/******************************************************************************/
@@ -0,0 +1,62 @@
+/*
+
+    This file is part of Dash Graphics Library
+    Copyright 2017 Benjamin Collins
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy of this
+    software and associated documentation files (the "Software"), to deal in the Software
+    without restriction, including without limitation the rights to use, copy, modify, merge,
+    publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+    to whom the Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all copies or
+    substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+    INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+    PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+    FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+    OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+*/
+
+
+#ifndef DASHGL_POOL
+#define DASHGL_POOL
+
+	/**********************************************************************/
+	/** Typedef                                                          **/
+	/**********************************************************************/
+
+	// Entities of one kind stored as one array per component. Live
+	// entities are always the first count of each array, a dead one is
+	// replaced by the last, so loops run over packed floats with no flag
+	// to test. Indices are not stable across a kill. The previous position
+	// is kept for drawing between steps.
+
+	typedef struct {
+		float *x;
+		float *y;
+		float *prev_x;
+		float *prev_y;
+		float *vx;
+		float *vy;
+		int *tick;
+		unsigned int *flags;
+		int count;
+		int capacity;
+	} DashPool;
+
+	/**********************************************************************/
+	/** Component Pool                                                   **/
+	/**********************************************************************/
+
+	int dash_pool_init(DashPool *pool, int capacity);
+	int dash_pool_spawn(DashPool *pool, float x, float y, float vx, float vy);
+	void dash_pool_kill(DashPool *pool, int index);
+	void dash_pool_remember(DashPool *pool);
+	void dash_pool_move(DashPool *pool);
+	void dash_pool_free(DashPool *pool);
+
+#endif
@@ -0,0 +1,214 @@
+/*
+    This file is part of Dash Graphics Library
+    Copyright 2017 Benjamin Collins
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy of this
+    software and associated documentation files (the "Software"), to deal in the Software
+    without restriction, including without limitation the rights to use, copy, modify, merge,
+    publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+    to whom the Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all copies or
+    substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+    INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+    PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+    FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+    OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+*/
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <GL/glew.h>
+#include "dashgl.h"
+#include "batch.h"
+#include "queue.h"
+
+/******************************************************************************/
+/** Render Queue                                                             **/
+/******************************************************************************/
+
+int dash_queue_init(DashQueue *queue, int capacity) {
+
+	memset(queue, 0, sizeof(DashQueue));
+	queue->capacity = capacity;
+
+	queue->keys = (uint64_t*)malloc(capacity * sizeof(uint64_t));
+	queue->keys_swap = (uint64_t*)malloc(capacity * sizeof(uint64_t));
+	queue->order = (unsigned int*)malloc(capacity * sizeof(unsigned int));
+	queue->order_swap = (unsigned int*)malloc(capacity * sizeof(unsigned int));
+	queue->packets = (DashPacket*)malloc(capacity * sizeof(DashPacket));
+
+	if(queue->keys == NULL || queue->keys_swap == NULL || queue->order == NULL ||
+		queue->order_swap == NULL || queue->packets == NULL) {
+		fprintf(stderr, "Could not allocate render queue\n");
+		dash_queue_free(queue);
+		return 0;
+	}
+
+	return 1;
+
+}
+
+uint64_t dash_queue_key(int layer, GLuint program, GLuint texture, float depth) {
+
+	uint32_t bits;
+	uint64_t key;
+
+	// Non-negative floats order the same as their bit patterns, which
+	// keeps depth exact without picking a quantization range
+
+	if(depth < 0.0f) {
+		depth = 0.0f;
+	}
+
+	memcpy(&bits, &depth, sizeof(bits));
+
+	key = (uint64_t)(layer & DASH_KEY_LAYER_MASK) << DASH_KEY_LAYER_SHIFT;
+	key |= (uint64_t)(program & DASH_KEY_NAME_MASK) << DASH_KEY_PROGRAM_SHIFT;
+	key |= (uint64_t)(texture & DASH_KEY_NAME_MASK) << DASH_KEY_TEXTURE_SHIFT;
+	key |= bits;
+
+	return key;
+
+}
+
+DashSprite *dash_queue_push(DashQueue *queue, uint64_t key, GLuint program, GLuint texture, unsigned int render) {
+
+	DashPacket *packet;
+
+	if(queue->count == queue->capacity) {
+		return NULL;
+	}
+
+	packet = &queue->packets[queue->count];
+	packet->program = program;
+	packet->texture = texture;
+	packet->render = render;
+
+	queue->keys[queue->count] = key;
+	queue->order[queue->count] = queue->count;
+	queue->count++;
+
+	return &packet->sprite;
+
+}
+
+void dash_queue_sort(DashQueue *queue) {
+
+	unsigned int counts[8][256];
+	unsigned int offsets[256];
+	unsigned int *order, *order_dst, *order_tmp;
+	uint64_t *keys, *keys_dst, *keys_tmp;
+	unsigned int sum, byte;
+	int i, pass, n;
+
+	n = queue->count;
+	if(n < 2) {
+		return;
+	}
+
+	// One read of the keys builds the histogram for every pass
+
+	memset(counts, 0, sizeof(counts));
+	for(i = 0; i < n; i++) {
+		for(pass = 0; pass < 8; pass++) {
+			counts[pass][(queue->keys[i] >> (pass * 8)) & 0xff]++;
+		}
+	}
+
+	keys = queue->keys;
+	keys_dst = queue->keys_swap;
+	order = queue->order;
+	order_dst = queue->order_swap;
+
+	// Least significant byte first, a stable counting sort per byte.
+	// Most packets share a layer, program and texture, so passes where
+	// every key has the same byte are skipped.
+
+	for(pass = 0; pass < 8; pass++) {
+
+		if(counts[pass][(keys[0] >> (pass * 8)) & 0xff] == (unsigned int)n) {
+			continue;
+		}
+
+		sum = 0;
+		for(i = 0; i < 256; i++) {
+			offsets[i] = sum;
+			sum += counts[pass][i];
+		}
+
+		for(i = 0; i < n; i++) {
+			byte = (keys[i] >> (pass * 8)) & 0xff;
+			keys_dst[offsets[byte]] = keys[i];
+			order_dst[offsets[byte]] = order[i];
+			offsets[byte]++;
+		}
+
+		keys_tmp = keys;
+		keys = keys_dst;
+		keys_dst = keys_tmp;
+
+		order_tmp = order;
+		order = order_dst;
+		order_dst = order_tmp;
+
+	}
+
+	queue->keys = keys;
+	queue->keys_swap = keys_dst;
+	queue->order = order;
+	queue->order_swap = order_dst;
+
+}
+
+void dash_queue_submit(DashQueue *queue, DashBatch *batch) {
+
+	DashPacket *packet;
+	DashSprite *s;
+	int i;
+
+	dash_queue_sort(queue);
+
+	// Packets come out grouped by state, the batch merges neighbours
+	// with the same program, texture and render state into one
+	// instanced draw
+
+	dash_batch_begin(batch);
+
+	for(i = 0; i < queue->count; i++) {
+
+		packet = &queue->packets[queue->order[i]];
+
+		s = dash_batch_push(batch, packet->program, packet->texture, packet->render);
+		if(s == NULL) {
+			break;
+		}
+
+		*s = packet->sprite;
+
+	}
+
+	dash_batch_draw(batch);
+	queue->count = 0;
+
+}
+
+void dash_queue_free(DashQueue *queue) {
+
+	free(queue->keys);
+	free(queue->keys_swap);
+	free(queue->order);
+	free(queue->order_swap);
+	free(queue->packets);
+	memset(queue, 0, sizeof(DashQueue));
+
+}
+
+/******************************************************************************/
+/** End Program                                                              **/
+/******************************************************************************/
@@ -0,0 +1,74 @@
+/*
+
+    This file is part of Dash Graphics Library
+    Copyright 2017 Benjamin Collins
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy of this
+    software and associated documentation files (the "Software"), to deal in the Software
+    without restriction, including without limitation the rights to use, copy, modify, merge,
+    publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+    to whom the Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all copies or
+    substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+    INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+    PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+    FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+    OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+*/
+
+#ifndef DASHGL_QUEUE
+#define DASHGL_QUEUE
+
+	/**********************************************************************/
+	/** Constants                                                        **/
+	/**********************************************************************/
+
+	// Sort key layout, most significant first. Program and texture only
+	// use their low bits for grouping; the packet keeps the full names
+	// and render state, so a collision costs a state change but never
+	// draws wrong.
+
+	#define DASH_KEY_LAYER_SHIFT 56
+	#define DASH_KEY_PROGRAM_SHIFT 44
+	#define DASH_KEY_TEXTURE_SHIFT 32
+	#define DASH_KEY_LAYER_MASK 0xff
+	#define DASH_KEY_NAME_MASK 0xfff
+
+	/**********************************************************************/
+	/** Typedef                                                          **/
+	/**********************************************************************/
+
+	typedef struct {
+		GLuint program;
+		GLuint texture;
+		unsigned int render;
+		DashSprite sprite;
+	} DashPacket;
+
+	typedef struct {
+		uint64_t *keys;
+		uint64_t *keys_swap;
+		unsigned int *order;
+		unsigned int *order_swap;
+		DashPacket *packets;
+		int count;
+		int capacity;
+	} DashQueue;
+
+	/**********************************************************************/
+	/** Render Queue                                                     **/
+	/**********************************************************************/
+
+	int dash_queue_init(DashQueue *queue, int capacity);
+	uint64_t dash_queue_key(int layer, GLuint program, GLuint texture, float depth);
+	DashSprite *dash_queue_push(DashQueue *queue, uint64_t key, GLuint program, GLuint texture, unsigned int render);
+	void dash_queue_sort(DashQueue *queue);
+	void dash_queue_submit(DashQueue *queue, DashBatch *batch);
+	void dash_queue_free(DashQueue *queue);
+
+#endif
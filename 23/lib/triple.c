@@ -0,0 +1,94 @@
+/*
+    This file is part of Dash Graphics Library
+    Copyright 2017 Benjamin Collins
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy of this
+    software and associated documentation files (the "Software"), to deal in the Software
+    without restriction, including without limitation the rights to use, copy, modify, merge,
+    publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+    to whom the Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all copies or
+    substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+    INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+    PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+    FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+    OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+*/
+#include <stdlib.h>
+#include <string.h>
+#include "triple.h"
+
+/******************************************************************************/
+/** Triple Buffer                                                            **/
+/******************************************************************************/
+
+int dash_triple_init(DashTriple *triple, size_t size) {
+
+	memset(triple, 0, sizeof(DashTriple));
+
+	triple->slots = (unsigned char*)calloc(3, size);
+	if(triple->slots == NULL) {
+		return 0;
+	}
+
+	triple->size = size;
+	triple->back = 0;
+	triple->middle = 1;
+	triple->front = 2;
+
+	return 1;
+
+}
+
+void *dash_triple_back(DashTriple *triple) {
+
+	return triple->slots + triple->back * triple->size;
+
+}
+
+void dash_triple_publish(DashTriple *triple) {
+
+	int old;
+
+	// Release makes the slot's contents visible before its index is
+
+	old = __atomic_exchange_n(
+		&triple->middle,
+		triple->back | DASH_TRIPLE_FRESH,
+		__ATOMIC_ACQ_REL
+	);
+
+	triple->back = old & ~DASH_TRIPLE_FRESH;
+
+}
+
+void *dash_triple_front(DashTriple *triple) {
+
+	int old;
+
+	// Without a new slot the reader keeps drawing the one it has
+
+	if(__atomic_load_n(&triple->middle, __ATOMIC_ACQUIRE) & DASH_TRIPLE_FRESH) {
+		old = __atomic_exchange_n(&triple->middle, triple->front, __ATOMIC_ACQ_REL);
+		triple->front = old & ~DASH_TRIPLE_FRESH;
+	}
+
+	return triple->slots + triple->front * triple->size;
+
+}
+
+void dash_triple_free(DashTriple *triple) {
+
+	free(triple->slots);
+	triple->slots = NULL;
+
+}
+
+/******************************************************************************/
+/** End Program                                                              **/
+/******************************************************************************/
@@ -0,0 +1,61 @@
+/*
+
+    This file is part of Dash Graphics Library
+    Copyright 2017 Benjamin Collins
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy of this
+    software and associated documentation files (the "Software"), to deal in the Software
+    without restriction, including without limitation the rights to use, copy, modify, merge,
+    publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+    to whom the Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all copies or
+    substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+    INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+    PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+    FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+    OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+*/
+
+#ifndef DASHGL_TRIPLE
+#define DASHGL_TRIPLE
+
+	/**********************************************************************/
+	/** Constants                                                        **/
+	/**********************************************************************/
+
+	// Set in the shared index when it holds a slot the reader hasn't seen
+
+	#define DASH_TRIPLE_FRESH 4
+
+	/**********************************************************************/
+	/** Typedef                                                          **/
+	/**********************************************************************/
+
+	// Three slots for one writer and one reader. The writer fills the back
+	// slot and swaps it with the shared one, the reader swaps the shared
+	// one with its front slot when it is fresh. Neither side ever waits.
+
+	typedef struct {
+		unsigned char *slots;
+		size_t size;
+		int back;
+		int front;
+		int middle;
+	} DashTriple;
+
+	/**********************************************************************/
+	/** Triple Buffer                                                    **/
+	/**********************************************************************/
+
+	int dash_triple_init(DashTriple *triple, size_t size);
+	void *dash_triple_back(DashTriple *triple);
+	void dash_triple_publish(DashTriple *triple);
+	void *dash_triple_front(DashTriple *triple);
+	void dash_triple_free(DashTriple *triple);
+
+#endif
@@ -19,68 +19,209 @@
 #include <GL/glew.h>
 #include <gtk/gtk.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
 #include "lib/dashgl.h"
+#include "lib/batch.h"
+#include "lib/atlas.h"
+#include "lib/anim.h"
+#include "lib/queue.h"
+#include "lib/capture.h"
+#include "lib/triple.h"
+#include "lib/pool.h"
 
 #define WIDTH 640.0f
 #define HEIGHT 480.0f
 #define NUM_ENEMIES 30
+#define NUM_BULLETS 7
+#define MAX_SPRITES (1 + NUM_BULLETS + NUM_ENEMIES)
+#define TICK_RATE 50
+#define TICK_USEC (1000000 / TICK_RATE)
+#define MAX_STEPS 5
 #define PADDING 4.0f
+#define CAPTURE_RATE 50
+#define CAPTURE_USEC (1000000 / CAPTURE_RATE)
+#define SPRITE_VERTEX "sdr/vertex_sprite.glsl"
+#define NUM_SPRITE_SHADERS 3
+
+// Draw order, back to front, and the depth each layer is drawn at
+
+#define LAYER_SHIP 0
+#define LAYER_BULLETS 1
+#define LAYER_ENEMIES 2
+#define LAYER_DEPTH(layer) (0.75f - 0.25f * (layer))
+
+// Queue layers used when opaque and translucent texels are split. All
+// opaque texels go first, sorted by state then front to back, and the
+// rest follows back to front.
+
+#define PASS_OPAQUE 0
+#define PASS_BLEND 128
 
 static void on_realize(GtkGLArea *area);
+static void on_unrealize(GtkGLArea *area);
 static void on_render(GtkGLArea *area, GdkGLContext *context);
-static gboolean on_idle(gpointer data);
+static gboolean on_redraw(gpointer data);
 static gint on_destroy(GtkWidget *widget);
 static gboolean on_keydown(GtkWidget *widget, GdkEventKey *event);
 static gboolean on_keyup(GtkWidget *widget, GdkEventKey *event);
-
-GLuint program, glInit;
-GLuint vao;
-GLint attribute_coord2d, attribute_texcoord;
-GLint uniform_mytexture, uniform_mvp;
+static GLuint create_sprite_program(const char *fragment);
+static GLuint build_sprite_program(const char *fragment);
+static int setup_sprite_program(GLuint sprite_program);
+static void start_reload(GtkGLArea *area);
+static gpointer reload_thread(gpointer data);
+static void swap_programs();
+static void game_init();
+static void game_free();
+static gboolean game_render(gint64 frame_time);
+static void game_remember();
+static void game_update();
+static gboolean game_step(gint64 time);
+static void game_snapshot(gint64 time);
+static gboolean on_tick(GtkWidget *widget, GdkFrameClock *clock, gpointer data);
+static gpointer sim_thread(gpointer data);
+static void request_redraw();
+static int run_headless(int num_frames, const char *filename);
+static void toggle_capture();
+static void queue_sprite(int layer, const GLfloat *pos, int frame);
+
+GLuint program, opaque_program, blend_program, glInit;
+gboolean split_alpha, dirty;
+GLenum present_filter;
+DashTarget target;
+DashCapture capture;
+gboolean recording;
+gint64 capture_next;
+const char *capture_path;
+GThread *reload;
+GAsyncQueue *reload_done;
+gint reload_stop;
+GThread *sim;
+GMutex sim_lock;
+GCond sim_wake;
+gboolean sim_stop;
+int sim_steps;
+gint64 sim_due, sim_last, sim_accum;
+guint sim_tick;
+gint redraw_pending;
+DashTriple snapshots;
+DashBatch batch;
+DashQueue queue;
+DashAtlas atlas;
 GtkWidget *glArea;
 
+// Sprite programs share the vertex shader and differ in the fragment
+// shader. The table order is also the order they are watched in.
+
 typedef struct {
-	vec3 pos;
-	gboolean active;
-	short tick;
-} Bullet;
+	GLuint *program;
+	const char *fragment;
+} SpriteShader;
+
+typedef struct {
+	int slot;
+	GLuint program;
+} ReloadResult;
+
+const SpriteShader sprite_shaders[NUM_SPRITE_SHADERS] = {
+	{ &program,        "sdr/fragment.glsl" },
+	{ &opaque_program, "sdr/fragment_opaque.glsl" },
+	{ &blend_program,  "sdr/fragment_blend.glsl" }
+};
+
+// Every animation frame in the game as a rectangle of its spritesheet,
+// and the clips that play them. Frames are picked in the vertex shader,
+// so adding frames does not add buffers or binds.
+
+const DashFrame frames[] = {
+	{ "ship.png",        32, 24, 16, 24, { 40.0f, 40.0f } },
+	{ "ship.png",        32,  0, 16, 24, { 40.0f, 40.0f } },
+	{ "laser-bolts.png",  0, 16, 16, 16, { 20.0f, 20.0f } },
+	{ "laser-bolts.png", 16, 16, 16, 16, { 20.0f, 20.0f } },
+	{ "enemy-small.png",  0,  0, 16, 16, { 48.0f, 48.0f } },
+	{ "enemy-small.png", 16,  0, 16, 16, { 48.0f, 48.0f } }
+};
+
+DashAnim anim;
+DashClip ship_clip = { 0, 2, 3 };
+DashClip bullet_clip = { 2, 2, 3 };
+DashClip enemy_small_clip = { 4, 2, 3 };
+
+// Every moving entity keeps where it was one step ago next to where it
+// is, so the renderer can draw it anywhere in between. Bullets and enemies
+// live in component pools, the flags of an enemy hold its type.
+
+// Input flags are set by the key handlers and read by the simulation
+// thread, always through g_atomic_int
 
 struct {
 	vec3 pos;
+	vec3 prev;
 	float dx, dy;
-	GLuint ship_vbo[2];
-	GLuint ship_tex;
-	GLuint bullet_vbo[2];
-	GLuint bullet_tex;
-	Bullet *bullets;
-	int num_bullets;
+	DashPool bullets;
 	float bullet_radius;
 	gboolean left_down;
 	gboolean right_down;
 	gboolean space_down;
+	gboolean fire;
 	short tick;
 	short tick_time;
 	short tick_len;
 } player;
 
 struct {
-	vec3 pos[NUM_ENEMIES];
-	gboolean active[NUM_ENEMIES];
-	int type[NUM_ENEMIES];
+	DashPool pool;
 	int tick;
-	GLuint enemy_small_tex;
-	GLuint enemy_small_vbo[2];
 	float radius;
 	float dx, dy;
 } enemies;
 
+// What the renderer needs from one simulation step. The simulation thread
+// fills one and publishes it, the render callback only reads the latest.
+// The time is the frame clock time the step was due at, 0 when there
+// is no frame clock.
+
+typedef struct {
+	int layer;
+	GLfloat pos[2];
+	GLfloat prev[2];
+	int frame;
+} SnapshotSprite;
+
+typedef struct {
+	SnapshotSprite sprites[MAX_SPRITES];
+	int num_sprites;
+	gint64 time;
+	gboolean moving;
+} Snapshot;
+
+static void snapshot_sprite(Snapshot *snapshot, int layer, float x, float y, float prev_x, float prev_y, int frame);
+
 int main(int argc, char *argv[]) {
 
 	GtkWidget *window;
-
-	gtk_init(&argc, &argv);
+	int i;
 
 	glInit = 0;
+	recording = FALSE;
+	capture_path = NULL;
+
+	// --capture names the recording, a .y4m file or the start of png
+	// names such as shots/frame. --headless renders a number of frames with no
+	// window and saves the last one, for machines without a display.
+
+	for(i = 1; i < argc; i++) {
+
+		if(strcmp(argv[i], "--capture") == 0 && i + 1 < argc) {
+			capture_path = argv[++i];
+		} else if(strcmp(argv[i], "--headless") == 0 && i + 2 < argc) {
+			return run_headless(atoi(argv[i + 1]), argv[i + 2]);
+		}
+
+	}
+
+	gtk_init(&argc, &argv);
 
 	window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
 	gtk_window_set_title(GTK_WINDOW(window), "DashGL - Shooter");
@@ -96,10 +237,10 @@ int main(int argc, char *argv[]) {
 	gtk_widget_set_hexpand(glArea, TRUE);
 	g_signal_connect(glArea, "realize", G_CALLBACK(on_realize), NULL);
 	g_signal_connect(glArea, "render", G_CALLBACK(on_render), NULL);
+	g_signal_connect(glArea, "unrealize", G_CALLBACK(on_unrealize), NULL);
 	gtk_container_add(GTK_CONTAINER(window), glArea);
 	g_signal_connect(G_OBJECT(glArea), "destroy", G_CALLBACK(on_destroy), NULL);
 
-	g_timeout_add(20, on_idle, NULL);
 	gtk_widget_show_all(window);
 
 	gtk_main();
@@ -108,14 +249,79 @@ int main(int argc, char *argv[]) {
 
 }
 
+/*****************************************************************************
+ * run headless
+ *****************************************************************************/
+
+static int run_headless(int num_frames, const char *filename) {
+
+	DashHeadless headless;
+	gint64 start, elapsed;
+	unsigned long issued, skipped;
+	int i;
+
+	if(!dash_headless_init(&headless, (int)WIDTH, (int)HEIGHT)) {
+		fprintf(stderr, "Headless context creation error\n");
+		return 1;
+	}
+
+	game_init();
+
+	// One frame is drawn per step, so the recording runs at the tick rate
+
+	if(capture_path != NULL) {
+		recording = dash_capture_start(&capture, capture_path, (int)WIDTH, (int)HEIGHT, TICK_RATE);
+	}
+
+	start = g_get_monotonic_time();
+
+	for(i = 0; i < num_frames; i++) {
+
+		game_step(0);
+		game_render(0);
+
+		if(recording) {
+			dash_capture_frame(&capture, headless.target.fbo, 1);
+		}
+
+	}
+
+	glFinish();
+	elapsed = g_get_monotonic_time() - start;
+
+	if(recording) {
+		dash_capture_stop(&capture);
+		printf("Captured %lu frames, dropped %lu\n", capture.frames, capture.dropped);
+		recording = FALSE;
+	}
+
+	if(num_frames > 0) {
+		printf("%d frames, %.3f ms per frame\n", num_frames, elapsed / 1000.0 / num_frames);
+		printf("One step per frame, %d steps per second\n", TICK_RATE);
+	}
+
+	dash_state_counters(&issued, &skipped);
+	printf("GL state calls: %lu issued, %lu skipped\n", issued, skipped);
+
+	if(!dash_headless_dump(&headless, filename)) {
+		fprintf(stderr, "Could not write %s\n", filename);
+		game_free();
+		dash_headless_free(&headless);
+		return 1;
+	}
+
+	game_free();
+	dash_headless_free(&headless);
+	return 0;
+
+}
+
 /*****************************************************************************
  * on realize
  *****************************************************************************/
 
 static void on_realize(GtkGLArea *area) {
 	
-	int i, col, row;
-
 	// Initialize
 
 	gtk_gl_area_make_current(area);
@@ -127,77 +333,112 @@ static void on_realize(GtkGLArea *area) {
 	glewExperimental = GL_TRUE;
 	glewInit();
 
-	// GL Version Informagtion
+	gtk_gl_area_set_has_depth_buffer(area, TRUE);
 
-	const GLubyte *renderer = glGetString(GL_RENDERER);
-	const GLubyte *version = glGetString(GL_VERSION);
-	printf("Renderer: %s\n", renderer);
-	printf("OpenGL version supported %s\n", version);
+	game_init();
 
-	gtk_gl_area_set_has_depth_buffer(area, TRUE);
+	// Offscreen target at the game's resolution, scaled up to the widget
+	// with nearest filtering unless switched
 
-	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+	if(!dash_target_init(&target, (int)WIDTH, (int)HEIGHT)) {
+		fprintf(stderr, "Render target creation error\n");
+		exit(1);
+	}
 
-	// Vertex Array Object
+	present_filter = GL_NEAREST;
 
-	glGenVertexArrays(1, &vao);
-	glBindVertexArray(vao);
+	start_reload(area);
 
-	// Create Program
+	// From here on the simulation state belongs to its own thread, which
+	// runs the steps the frame clock says are due
 
-	program = dash_create_program("sdr/vertex.glsl", "sdr/fragment.glsl");
-	if(program == 0) {
-		fprintf(stderr, "Program creation error\n");
-		exit(1);
-	}
-	glUseProgram(program);
+	sim_stop = FALSE;
+	sim_steps = 0;
+	sim_last = 0;
+	sim_accum = 0;
+	sim = g_thread_new("simulation", sim_thread, NULL);
+	sim_tick = gtk_widget_add_tick_callback(GTK_WIDGET(area), on_tick, NULL, NULL);
 
+}
 
-	// Bind Attributes
+static void on_unrealize(GtkGLArea *area) {
 
-	const char *attribute_name = "coord2d";
-	attribute_coord2d = glGetAttribLocation(program, attribute_name);
-	if(attribute_coord2d == -1) {
-		fprintf(stderr, "Could not bind attribute %s\n", attribute_name);
-		return;
+	ReloadResult *result;
+
+	// Nothing may step, reload or redraw once the context is gone, so
+	// the tick callback and both threads are stopped first
+
+	if(sim != NULL) {
+		gtk_widget_remove_tick_callback(GTK_WIDGET(area), sim_tick);
+		g_mutex_lock(&sim_lock);
+		sim_stop = TRUE;
+		g_cond_signal(&sim_wake);
+		g_mutex_unlock(&sim_lock);
+		g_thread_join(sim);
+		sim = NULL;
 	}
-	
-	attribute_name = "texcoord";
-	attribute_texcoord = glGetAttribLocation(program, attribute_name);
-	if(attribute_texcoord == -1) {
-		fprintf(stderr, "Could not bind attribute %s\n", attribute_name);
-		return;
+
+	if(reload != NULL) {
+		g_atomic_int_set(&reload_stop, 1);
+		g_thread_join(reload);
+		dash_watch_free();
+		reload = NULL;
 	}
 
-	// Bind Uniforms
+	// Both threads were the only ones to add the idle redraw
 
-	const char *uniform_name = "mvp";
-	uniform_mvp = glGetUniformLocation(program, uniform_name);
-	if(uniform_mvp == -1) {
-		fprintf(stderr, "Could not bind uniform %s\n", uniform_name);
+	g_idle_remove_by_data(&redraw_pending);
+	g_atomic_int_set(&redraw_pending, 0);
+
+	gtk_gl_area_make_current(area);
+	if(gtk_gl_area_get_error(area) != NULL) {
 		return;
 	}
 
-	uniform_name = "ortho";
-	GLint uniform_ortho = glGetUniformLocation(program, uniform_name);
-	if(uniform_ortho == -1) {
-		fprintf(stderr, "Could not bind uniform %s\n", uniform_name);
-		return;
+	// Stopping the recording waits for its writer to finish the queue
+
+	if(recording) {
+		toggle_capture();
 	}
-	
-	uniform_name = "mytexture";
-	uniform_mytexture = glGetUniformLocation(program, uniform_name);
-	if(uniform_mytexture == -1) {
-		fprintf(stderr, "Could not bind uniform %s\n", uniform_name);
-		return;
+
+	// Programs built after the last frame was drawn were never swapped in
+
+	if(reload_done != NULL) {
+		while((result = (ReloadResult*)g_async_queue_try_pop(reload_done)) != NULL) {
+			glDeleteProgram(result->program);
+			g_free(result);
+		}
+		g_async_queue_unref(reload_done);
+		reload_done = NULL;
 	}
 
-	// Set orthographics
+	dash_target_free(&target);
+	game_free();
+
+}
+
+/*****************************************************************************
+ * game init
+ *****************************************************************************/
+
+// Everything after the context is current, shared by the window and the
+// headless runner
+
+static void game_init() {
+
+	int i, k, col, row;
+
+	dash_state_reset();
+
+	// GL Version Informagtion
+
+	const GLubyte *renderer = glGetString(GL_RENDERER);
+	const GLubyte *version = glGetString(GL_VERSION);
+	printf("Renderer: %s\n", renderer);
+	printf("OpenGL version supported %s\n", version);
+
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 
-	mat4 ortho;
-	mat4_orthographic(0, WIDTH, HEIGHT, 0, ortho);
-	glUniformMatrix4fv(uniform_ortho, 1, GL_FALSE, ortho);
-	
 	// Player
 
 	player.pos[0] = 320.0f;
@@ -209,96 +450,55 @@ static void on_realize(GtkGLArea *area) {
 	player.left_down = FALSE;
 	player.right_down = FALSE;
 	player.space_down = FALSE;
+	player.fire = FALSE;
 
 	player.tick_time = 6;
 	player.tick_len = player.tick_time / 2;
 	player.tick = player.tick_time - 1;
 
-	player.num_bullets = 7;
-	player.bullets = (Bullet*)malloc(player.num_bullets * sizeof(Bullet));
 	player.bullet_radius = 10.0f;
 
-	for(i = 0; i < player.num_bullets; i++) {
-		player.bullets[i].active = FALSE;
-	}
-
-	// Player - Ships
-
-	player.ship_tex = dash_texture_load("spritesheets/ship.png");
-	GLfloat ship_vertices[][24] = {
-		{
-			-20.0, -20.0, 0.4f, 1.0f,
-			-20.0,  20.0, 0.4f, 0.5f,
-			 20.0,  20.0, 0.6f, 0.5f,
-			 20.0,  20.0, 0.6f, 0.5f,
-			 20.0, -20.0, 0.6f, 1.0f,
-			-20.0, -20.0, 0.4f, 1.0f
-		}, {
-			-20.0, -20.0, 0.4f, 0.5f,
-			-20.0,  20.0, 0.4f, 0.0f,
-			 20.0,  20.0, 0.6f, 0.0f,
-			 20.0,  20.0, 0.6f, 0.0f,
-			 20.0, -20.0, 0.6f, 0.5f,
-			-20.0, -20.0, 0.4f, 0.5f
-		}
-	};
+	if(!dash_pool_init(&player.bullets, NUM_BULLETS)) {
+		fprintf(stderr, "Bullet pool creation error\n");
+		exit(1);
+	}
 
-	glGenBuffers(2, player.ship_vbo);
+	// Texture Atlas
 
-	glBindBuffer(GL_ARRAY_BUFFER, player.ship_vbo[0]);
-	glBufferData(
-		GL_ARRAY_BUFFER,
-		sizeof(ship_vertices[0]),
-		ship_vertices[0],
-		GL_STATIC_DRAW
-	);
+	if(dash_atlas_build(&atlas, "spritesheets") == 0) {
+		fprintf(stderr, "Texture atlas creation error\n");
+		exit(1);
+	}
 
-	glBindBuffer(GL_ARRAY_BUFFER, player.ship_vbo[1]);
-	glBufferData(
-		GL_ARRAY_BUFFER,
-		sizeof(ship_vertices[1]),
-		ship_vertices[1],
-		GL_STATIC_DRAW
-	);
-	
-	// Player - Bullets
-
-	player.bullet_tex = dash_texture_load("spritesheets/laser-bolts.png");
-	GLfloat bullet_vertices[][24] = {
-		{
-			-player.bullet_radius, -player.bullet_radius, 0.0f, 1.0f,
-			-player.bullet_radius,  player.bullet_radius, 0.0f, 0.5f,
-			 player.bullet_radius,  player.bullet_radius, 0.5f, 0.5f,
-			 player.bullet_radius,  player.bullet_radius, 0.5f, 0.5f,
-			 player.bullet_radius, -player.bullet_radius, 0.5f, 1.0f,
-			-player.bullet_radius, -player.bullet_radius, 0.0f, 1.0f
-		}, {
-			-player.bullet_radius, -player.bullet_radius, 0.5f, 1.0f,
-			-player.bullet_radius,  player.bullet_radius, 0.5f, 0.5f,
-			 player.bullet_radius,  player.bullet_radius, 1.0f, 0.5f,
-			 player.bullet_radius,  player.bullet_radius, 1.0f, 0.5f,
-			 player.bullet_radius, -player.bullet_radius, 1.0f, 1.0f,
-			-player.bullet_radius, -player.bullet_radius, 0.5f, 1.0f
-		}
-	};
+	// Animation Frames
 
-	glGenBuffers(2, player.bullet_vbo);
+	if(!dash_anim_build(&anim, &atlas, frames, sizeof(frames) / sizeof(DashFrame))) {
+		fprintf(stderr, "Animation table creation error\n");
+		exit(1);
+	}
 
-	glBindBuffer(GL_ARRAY_BUFFER, player.bullet_vbo[0]);
-	glBufferData(
-		GL_ARRAY_BUFFER,
-		sizeof(bullet_vertices[0]),
-		bullet_vertices[0],
-		GL_STATIC_DRAW
-	);
+	// Sprite Batch, split mode queues every sprite once per pass. Comes
+	// before the programs, which are linked with its attribute locations.
 
-	glBindBuffer(GL_ARRAY_BUFFER, player.bullet_vbo[1]);
-	glBufferData(
-		GL_ARRAY_BUFFER,
-		sizeof(bullet_vertices[1]),
-		bullet_vertices[1],
-		GL_STATIC_DRAW
-	);
+	if(!dash_batch_init(&batch, 2 * MAX_SPRITES)) {
+		fprintf(stderr, "Sprite batch creation error\n");
+		exit(1);
+	}
+
+	// Programs, one per fragment variant sharing the sprite vertex shader
+
+	for(i = 0; i < NUM_SPRITE_SHADERS; i++) {
+		*sprite_shaders[i].program = create_sprite_program(sprite_shaders[i].fragment);
+	}
+
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	split_alpha = TRUE;
+	dirty = TRUE;
+
+	if(!dash_queue_init(&queue, batch.capacity)) {
+		fprintf(stderr, "Render queue creation error\n");
+		exit(1);
+	}
 
 	// Enemies 
 	
@@ -307,57 +507,38 @@ static void on_realize(GtkGLArea *area) {
 	enemies.dx = 1.0f;
 	enemies.tick = player.tick_len - 1;
 
-	enemies.enemy_small_tex = dash_texture_load("spritesheets/enemy-small.png");
+	if(!dash_pool_init(&enemies.pool, NUM_ENEMIES)) {
+		fprintf(stderr, "Enemy pool creation error\n");
+		exit(1);
+	}
 
 	for(i = 0; i < NUM_ENEMIES; i++) {
 		
 		col = i % 10;
 		row = i / 10;
 
-		enemies.active[i] = TRUE;
-		enemies.type[i] = row;
-		enemies.pos[i][0] = PADDING + enemies.radius + (2*enemies.radius + PADDING) * col;
-		enemies.pos[i][1] = PADDING + enemies.radius + (2*enemies.radius + PADDING) * row;
-		enemies.pos[i][1] = HEIGHT - enemies.pos[i][1];
-		enemies.pos[i][2] = 0.0f;
+		k = dash_pool_spawn(
+			&enemies.pool,
+			PADDING + enemies.radius + (2*enemies.radius + PADDING) * col,
+			HEIGHT - (PADDING + enemies.radius + (2*enemies.radius + PADDING) * row),
+			0.0f,
+			0.0f
+		);
+
+		enemies.pool.flags[k] = row;
 
 	}
-	
-	GLfloat enemy_small_vertices[][24] = {
-		{
-			-enemies.radius, -enemies.radius, 0.0f, 1.0f,
-			-enemies.radius,  enemies.radius, 0.0f, 0.0f,
-			 enemies.radius,  enemies.radius, 0.5f, 0.0f,
-			 enemies.radius,  enemies.radius, 0.5f, 0.0f,
-			 enemies.radius, -enemies.radius, 0.5f, 1.0f,
-			-enemies.radius, -enemies.radius, 0.0f, 1.0f
-		},{
-			-enemies.radius, -enemies.radius, 0.5f, 1.0f,
-			-enemies.radius,  enemies.radius, 0.5f, 0.0f,
-			 enemies.radius,  enemies.radius, 1.0f, 0.0f,
-			 enemies.radius,  enemies.radius, 1.0f, 0.0f,
-			 enemies.radius, -enemies.radius, 1.0f, 1.0f,
-			-enemies.radius, -enemies.radius, 0.5f, 1.0f
-		}
-	};
 
-	glGenBuffers(2, enemies.enemy_small_vbo);
+	game_remember();
 
-	glBindBuffer(GL_ARRAY_BUFFER, enemies.enemy_small_vbo[0]);
-	glBufferData(
-		GL_ARRAY_BUFFER,
-		sizeof(enemy_small_vertices[0]),
-		enemy_small_vertices[0],
-		GL_STATIC_DRAW
-	);
+	// Snapshots, the first one is published before anything runs
 
-	glBindBuffer(GL_ARRAY_BUFFER, enemies.enemy_small_vbo[1]);
-	glBufferData(
-		GL_ARRAY_BUFFER,
-		sizeof(enemy_small_vertices[1]),
-		enemy_small_vertices[1],
-		GL_STATIC_DRAW
-	);
+	if(!dash_triple_init(&snapshots, sizeof(Snapshot))) {
+		fprintf(stderr, "Snapshot creation error\n");
+		exit(1);
+	}
+
+	game_snapshot(0);
 
 	// End Init
 
@@ -365,158 +546,616 @@ static void on_realize(GtkGLArea *area) {
 
 }
 
+static void game_free() {
+
+	int i;
+
+	// Undoes game_init, with the same context current
+
+	dash_use_program(0);
+
+	for(i = 0; i < NUM_SPRITE_SHADERS; i++) {
+		dash_state_forget_program(*sprite_shaders[i].program);
+		glDeleteProgram(*sprite_shaders[i].program);
+		*sprite_shaders[i].program = 0;
+	}
+
+	dash_queue_free(&queue);
+	dash_batch_free(&batch);
+	dash_atlas_free(&atlas);
+	dash_pool_free(&player.bullets);
+	dash_pool_free(&enemies.pool);
+	dash_triple_free(&snapshots);
+
+	glInit = 0;
+
+}
+
 static void on_render(GtkGLArea *area, GdkGLContext *context) {
 
+	GLint fbo;
+	int scale, width, height, copies;
+	gint64 frame_time;
+	gboolean moving;
+	GLenum filter;
+
+	// Rebuilt shaders only change hands between frames
+
+	swap_programs();
+
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &fbo);
+	frame_time = gdk_frame_clock_get_frame_time(gtk_widget_get_frame_clock(GTK_WIDGET(area)));
+
+	if(present_filter == 0 && !recording) {
+
+		moving = game_render(frame_time);
+
+	} else {
+
+		// Draw at the fixed resolution and scale the result onto the
+		// widget's framebuffer, so a large window doesn't mean more
+		// fragments. Recordings are always taken from the target, so
+		// drawing straight to the widget waits until they stop.
+
+		scale = gtk_widget_get_scale_factor(GTK_WIDGET(area));
+		width = gtk_widget_get_allocated_width(GTK_WIDGET(area)) * scale;
+		height = gtk_widget_get_allocated_height(GTK_WIDGET(area)) * scale;
+		filter = present_filter == 0 ? GL_NEAREST : present_filter;
+
+		dash_target_bind(&target);
+		moving = game_render(frame_time);
+		dash_target_blit(&target, fbo, width, height, filter);
+
+	}
+
+	// The recording has a fixed rate while frames come at the display's
+	// pace, so each one stands for however many recorded frames have
+	// come due on the frame clock since the last, none if it is early
+
+	if(recording) {
+
+		if(capture_next == 0) {
+			capture_next = frame_time;
+		}
+
+		copies = 0;
+
+		while(frame_time >= capture_next) {
+			capture_next += CAPTURE_USEC;
+			copies++;
+		}
+
+		if(copies > 0) {
+			dash_capture_frame(&capture, target.fbo, copies);
+		}
+
+	}
+
+	// Keep drawing at the display's rate until the motion of the last
+	// step has played out
+
+	if(moving) {
+		gtk_widget_queue_draw(GTK_WIDGET(area));
+	}
+
+}
+
+static gboolean game_render(gint64 frame_time) {
+
+	Snapshot *snapshot;
+	SnapshotSprite *sprite;
+	GLfloat alpha, pos[2];
+	int i;
+
+	// Depth writes have to be on for the clear to reach the depth buffer
+
+	dash_render_state(DASH_DEPTH_WRITE);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	
-	int i, sprite;
-	mat4 mvp;
 
-	// glBindVertexArray(vao);
+	// Latest published step, the simulation may already be writing the
+	// next one
 
-	// Draw Player
-	
-	glActiveTexture(GL_TEXTURE0);
+	snapshot = (Snapshot*)dash_triple_front(&snapshots);
 
-	// Player Sprite
+	// Sprites are drawn between their last two positions, as far along
+	// as the frame is past the step. This trails the simulation by up to
+	// a step but moves smoothly at any refresh rate. Without a frame
+	// time, as when headless, the step itself is drawn.
 
-	glBindTexture(GL_TEXTURE_2D, player.ship_tex);
-	glUniform1i(uniform_mytexture, 0);
+	alpha = 1.0f;
 
-	glEnableVertexAttribArray(attribute_coord2d);
-	glEnableVertexAttribArray(attribute_texcoord);
-	
-	sprite = player.tick / player.tick_len;
-	
-	glBindBuffer(GL_ARRAY_BUFFER, player.ship_vbo[sprite]);
-	
-	glVertexAttribPointer(
-		attribute_coord2d,
-		2,
-		GL_FLOAT,
-		GL_FALSE,
-		sizeof(float) * 4,
-		0
+	if(frame_time > 0) {
+		alpha = (GLfloat)(frame_time - snapshot->time) / TICK_USEC;
+		if(alpha < 0.0f) {
+			alpha = 0.0f;
+		} else if(alpha > 1.0f) {
+			alpha = 1.0f;
+		}
+	}
+
+	for(i = 0; i < snapshot->num_sprites; i++) {
+		sprite = &snapshot->sprites[i];
+		pos[0] = sprite->prev[0] + (sprite->pos[0] - sprite->prev[0]) * alpha;
+		pos[1] = sprite->prev[1] + (sprite->pos[1] - sprite->prev[1]) * alpha;
+		queue_sprite(sprite->layer, pos, sprite->frame);
+	}
+
+	// Sort by layer and state, then draw each run of packets sharing a
+	// program, texture and render state with one instanced call
+
+	dash_queue_submit(&queue, &batch);
+
+	return snapshot->moving && alpha < 1.0f;
+
+}
+
+static void queue_sprite(int layer, const GLfloat *pos, int frame) {
+
+	DashSprite sprite, *s;
+	uint64_t key;
+
+	sprite.pos[0] = pos[0];
+	sprite.pos[1] = pos[1];
+	sprite.scale = 1.0f;
+	sprite.rotation = 0.0f;
+	sprite.frame = frame;
+	sprite.depth = LAYER_DEPTH(layer);
+
+	if(!split_alpha) {
+		key = dash_queue_key(layer, program, atlas.texture, 0.0f);
+		s = dash_queue_push(&queue, key, program, atlas.texture, 0);
+		if(s != NULL) {
+			*s = sprite;
+		}
+		return;
+	}
+
+	// Opaque texels with depth writes, front to back within a state
+
+	key = dash_queue_key(PASS_OPAQUE, opaque_program, atlas.texture, sprite.depth);
+	s = dash_queue_push(
+		&queue,
+		key,
+		opaque_program,
+		atlas.texture,
+		DASH_DEPTH_TEST | DASH_DEPTH_WRITE
 	);
+	if(s != NULL) {
+		*s = sprite;
+	}
+
+	// Everything else blended on top, the depth test drops what the
+	// opaque pass already covered
 
-	glVertexAttribPointer(
-		attribute_texcoord,
-		2,
-		GL_FLOAT,
-		GL_FALSE,
-		sizeof(float) * 4,
-		(void*)(sizeof(float) * 2)
+	key = dash_queue_key(PASS_BLEND + layer, blend_program, atlas.texture, 0.0f);
+	s = dash_queue_push(
+		&queue,
+		key,
+		blend_program,
+		atlas.texture,
+		DASH_DEPTH_TEST | DASH_BLEND
 	);
+	if(s != NULL) {
+		*s = sprite;
+	}
 
-	mat4_translate(player.pos, mvp);
-	glUniformMatrix4fv(uniform_mvp, 1, GL_FALSE, mvp);
-	glDrawArrays(GL_TRIANGLES, 0, 6);
+}
 
-	// Player Bullets
-	
-	glActiveTexture(GL_TEXTURE1);
-	glBindTexture(GL_TEXTURE_2D, player.bullet_tex);
-	glUniform1i(uniform_mytexture, 1);
+static GLuint create_sprite_program(const char *fragment) {
 
-	for(i = 0; i < player.num_bullets; i++) {
-		
-		if(!player.bullets[i].active) {
-			continue;
-		}
-		
-		sprite = player.bullets[i].tick / player.tick_len;
-		glBindBuffer(GL_ARRAY_BUFFER, player.bullet_vbo[sprite]);
-
-		glVertexAttribPointer(
-			attribute_coord2d,
-			2,
-			GL_FLOAT,
-			GL_FALSE,
-			sizeof(float) * 4,
-			0
-		);
+	GLuint sprite_program;
 
-		glVertexAttribPointer(
-			attribute_texcoord,
-			2,
-			GL_FLOAT,
-			GL_FALSE,
-			sizeof(float) * 4,
-			(void*)(sizeof(float) * 2)
-		);
+	sprite_program = build_sprite_program(fragment);
+	if(sprite_program == 0 || !setup_sprite_program(sprite_program)) {
+		fprintf(stderr, "Program creation error\n");
+		exit(1);
+	}
+
+	return sprite_program;
+
+}
 
-		mat4_translate(player.bullets[i].pos, mvp);
-		glUniformMatrix4fv(uniform_mvp, 1, GL_FALSE, mvp);
-		glDrawArrays(GL_TRIANGLES, 0, 6);
+static GLuint build_sprite_program(const char *fragment) {
 
+	GLuint sprite_program;
+
+	sprite_program = dash_create_program(SPRITE_VERTEX, fragment);
+	if(sprite_program == 0 || dash_batch_pinned(sprite_program)) {
+		return sprite_program;
 	}
 
-	// Draw Enemies
-	
-	for(i = 0; i < NUM_ENEMIES; i++) {
+	// A cached binary linked with other locations, compile it from
+	// source instead
 
-		glActiveTexture(GL_TEXTURE2);
-		glBindTexture(GL_TEXTURE_2D, enemies.enemy_small_tex);
-		glUniform1i(uniform_mytexture, 2);
+	glDeleteProgram(sprite_program);
+	dash_program_cache_drop(SPRITE_VERTEX, fragment);
 
-		if(!enemies.active[i]) {
-			continue;
+	sprite_program = dash_create_program(SPRITE_VERTEX, fragment);
+	if(sprite_program != 0 && !dash_batch_pinned(sprite_program)) {
+		glDeleteProgram(sprite_program);
+		return 0;
+	}
+
+	return sprite_program;
+
+}
+
+static int setup_sprite_program(GLuint sprite_program) {
+
+	GLint uniform_ortho;
+	GLfloat ortho_2d[4];
+	mat4 ortho;
+
+	if(!dash_batch_program(sprite_program)) {
+		return 0;
+	}
+
+	dash_use_program(sprite_program);
+
+	// Bind Uniforms
+
+	const char *uniform_name = "ortho";
+	uniform_ortho = glGetUniformLocation(sprite_program, uniform_name);
+	if(uniform_ortho == -1) {
+		fprintf(stderr, "Could not bind uniform %s\n", uniform_name);
+		return 0;
+	}
+
+	// Set orthographics, only the 2D scale and offset reach the shader
+
+	mat4_orthographic(0, WIDTH, HEIGHT, 0, ortho);
+	ortho_2d[0] = ortho[M_00];
+	ortho_2d[1] = ortho[M_11];
+	ortho_2d[2] = ortho[M_03];
+	ortho_2d[3] = ortho[M_13];
+	dash_uniform4fv(uniform_ortho, ortho_2d);
+
+	dash_anim_upload(&anim, sprite_program);
+
+	return 1;
+
+}
+
+/*****************************************************************************
+ * shader reload
+ *****************************************************************************/
+
+// Saved shaders are rebuilt on a second context sharing objects with the
+// area's, in a thread of its own, and swapped in before the next frame.
+// The render thread only sets the new program's uniforms.
+
+static void start_reload(GtkGLArea *area) {
+
+	GdkGLContext *context;
+	GError *error;
+	int i;
+
+	if(!dash_watch_init()) {
+		return;
+	}
+
+	for(i = 0; i < NUM_SPRITE_SHADERS; i++) {
+		if(dash_watch_program(SPRITE_VERTEX, sprite_shaders[i].fragment) != i) {
+			dash_watch_free();
+			return;
 		}
-		
-		sprite = enemies.tick / player.tick_len;
-		glBindBuffer(GL_ARRAY_BUFFER, enemies.enemy_small_vbo[sprite]);
-
-		glVertexAttribPointer(
-			attribute_coord2d,
-			2,
-			GL_FLOAT,
-			GL_FALSE,
-			sizeof(float) * 4,
-			0
-		);
+	}
 
-		glVertexAttribPointer(
-			attribute_texcoord,
-			2,
-			GL_FLOAT,
-			GL_FALSE,
-			sizeof(float) * 4,
-			(void*)(sizeof(float) * 2)
-		);
+	error = NULL;
+	context = gdk_window_create_gl_context(gtk_widget_get_window(GTK_WIDGET(area)), &error);
+	if(context == NULL || !gdk_gl_context_realize(context, &error)) {
+		fprintf(stderr, "Shader reload disabled: %s\n", error != NULL ? error->message : "no context");
+		g_clear_error(&error);
+		dash_watch_free();
+		return;
+	}
+
+	reload_stop = 0;
+	reload_done = g_async_queue_new();
+	reload = g_thread_new("shader-reload", reload_thread, context);
+
+	// Creating the context made it current, the area's has to be again
+
+	gtk_gl_area_make_current(area);
+
+}
+
+static gpointer reload_thread(gpointer data) {
+
+	GdkGLContext *context;
+	ReloadResult *result;
+	GLuint built;
+	int slots[NUM_SPRITE_SHADERS];
+	int i, n;
+
+	context = (GdkGLContext*)data;
+	gdk_gl_context_make_current(context);
+
+	while(!g_atomic_int_get(&reload_stop)) {
 
-		mat4_translate(enemies.pos[i], mvp);
-		glUniformMatrix4fv(uniform_mvp, 1, GL_FALSE, mvp);
-		glDrawArrays(GL_TRIANGLES, 0, 6);
+		n = dash_watch_wait(slots, NUM_SPRITE_SHADERS, 250);
+
+		for(i = 0; i < n; i++) {
+
+			built = build_sprite_program(sprite_shaders[slots[i]].fragment);
+			if(built == 0) {
+				fprintf(stderr, "Keeping the previous %s\n", sprite_shaders[slots[i]].fragment);
+				continue;
+			}
+
+			// The other context may only use the program once it is
+			// completely built
+
+			glFinish();
+
+			result = g_new(ReloadResult, 1);
+			result->slot = slots[i];
+			result->program = built;
+			g_async_queue_push(reload_done, result);
+			request_redraw();
+
+		}
 
 	}
 
-	// Disable Arrays
+	gdk_gl_context_clear_current();
+	g_object_unref(context);
+	return NULL;
+
+}
+
+static void swap_programs() {
+
+	ReloadResult *result;
+	GLuint *slot;
+
+	if(reload_done == NULL) {
+		return;
+	}
 
-	glDisableVertexAttribArray(attribute_coord2d);
-	glDisableVertexAttribArray(attribute_texcoord);
+	while((result = (ReloadResult*)g_async_queue_try_pop(reload_done)) != NULL) {
+
+		slot = sprite_shaders[result->slot].program;
+		dash_state_forget_program(result->program);
+
+		if(setup_sprite_program(result->program)) {
+			glDeleteProgram(*slot);
+			*slot = result->program;
+			g_print("Reloaded %s\n", sprite_shaders[result->slot].fragment);
+		} else {
+			glDeleteProgram(result->program);
+		}
+
+		g_free(result);
+
+	}
 
 }
 
 /*****************************************************************************
- * on idle
+ * simulation
  *****************************************************************************/
 
-static gboolean on_idle(gpointer data) {
+static gboolean on_tick(GtkWidget *widget, GdkFrameClock *clock, gpointer data) {
+
+	gint64 now;
+	int steps;
+
+	// Called once per frame, in step with the display. The time since
+	// the last frame goes into the accumulator and every whole tick in it
+	// becomes a step for the simulation thread.
+
+	now = gdk_frame_clock_get_frame_time(clock);
+
+	// A recording needs a frame on every tick, even when nothing moves
+
+	if(recording) {
+		gtk_widget_queue_draw(widget);
+	}
+
+	if(sim_last == 0) {
+		sim_last = now;
+	}
+
+	sim_accum += now - sim_last;
+	sim_last = now;
+
+	// After a stall, like a dragged window or a suspended machine, only a
+	// few steps are caught up and the rest of the time is dropped, so
+	// steps that take too long can't pile up faster than they run
+
+	if(sim_accum > MAX_STEPS * TICK_USEC) {
+		sim_accum = MAX_STEPS * TICK_USEC;
+	}
+
+	steps = (int)(sim_accum / TICK_USEC);
+	sim_accum -= (gint64)steps * TICK_USEC;
+
+	if(steps == 0) {
+		return G_SOURCE_CONTINUE;
+	}
+
+	// The latest step is due where the leftover time starts, the
+	// renderer interpolates from there
+
+	g_mutex_lock(&sim_lock);
+	sim_steps += steps;
+	if(sim_steps > MAX_STEPS) {
+		sim_steps = MAX_STEPS;
+	}
+	sim_due = now - sim_accum;
+	g_cond_signal(&sim_wake);
+	g_mutex_unlock(&sim_lock);
+
+	return G_SOURCE_CONTINUE;
+
+}
+
+static gpointer sim_thread(gpointer data) {
+
+	gint64 due;
+	int i, steps;
+	gboolean published;
+
+	g_mutex_lock(&sim_lock);
+
+	while(!sim_stop) {
+
+		if(sim_steps == 0) {
+			g_cond_wait(&sim_wake, &sim_lock);
+			continue;
+		}
+
+		steps = sim_steps;
+		due = sim_due;
+		sim_steps = 0;
+		g_mutex_unlock(&sim_lock);
+
+		// Each step is stamped with the frame clock time it was due at,
+		// one tick apart back from the latest
+
+		published = FALSE;
+
+		for(i = 0; i < steps; i++) {
+			if(game_step(due - (gint64)(steps - 1 - i) * TICK_USEC)) {
+				published = TRUE;
+			}
+		}
+
+		if(published) {
+			request_redraw();
+		}
+
+		g_mutex_lock(&sim_lock);
+
+	}
+
+	g_mutex_unlock(&sim_lock);
+	return NULL;
+
+}
+
+static void request_redraw() {
+
+	// Safe from any thread, at most one redraw is waiting at a time
+
+	if(g_atomic_int_compare_and_exchange(&redraw_pending, 0, 1)) {
+		g_idle_add(on_redraw, &redraw_pending);
+	}
+
+}
+
+static gboolean on_redraw(gpointer data) {
+
+	g_atomic_int_set(&redraw_pending, 0);
+	gtk_widget_queue_draw(glArea);
 
-	int i, k, move_down, shoot;
-	float dx, dy, radius;
+	return FALSE;
 
-	if(glInit == 0) {
+}
+
+static gboolean game_step(gint64 time) {
+
+	// Only a step that changed something on screen is published
+
+	game_update();
+
+	if(!dirty) {
 		return FALSE;
 	}
 
+	game_snapshot(time);
+	dirty = FALSE;
+
+	return TRUE;
+
+}
+
+static void game_snapshot(gint64 time) {
+
+	Snapshot *snapshot;
+	DashPool *bullets, *pool;
+	int i, frame;
+
+	snapshot = (Snapshot*)dash_triple_back(&snapshots);
+	snapshot->num_sprites = 0;
+	snapshot->moving = FALSE;
+
+	// Player Sprite
+
+	frame = dash_anim_frame(&ship_clip, player.tick);
+	snapshot_sprite(snapshot, LAYER_SHIP, player.pos[0], player.pos[1], player.prev[0], player.prev[1], frame);
+
+	// Player Bullets
+
+	bullets = &player.bullets;
+
+	for(i = 0; i < bullets->count; i++) {
+		frame = dash_anim_frame(&bullet_clip, bullets->tick[i]);
+		snapshot_sprite(snapshot, LAYER_BULLETS, bullets->x[i], bullets->y[i], bullets->prev_x[i], bullets->prev_y[i], frame);
+	}
+
+	// Enemies
+
+	pool = &enemies.pool;
+	frame = dash_anim_frame(&enemy_small_clip, enemies.tick);
+
+	for(i = 0; i < pool->count; i++) {
+		snapshot_sprite(snapshot, LAYER_ENEMIES, pool->x[i], pool->y[i], pool->prev_x[i], pool->prev_y[i], frame);
+	}
+
+	snapshot->time = time;
+	dash_triple_publish(&snapshots);
+
+}
+
+static void snapshot_sprite(Snapshot *snapshot, int layer, float x, float y, float prev_x, float prev_y, int frame) {
+
+	SnapshotSprite *sprite;
+
+	sprite = &snapshot->sprites[snapshot->num_sprites++];
+	sprite->layer = layer;
+	sprite->pos[0] = x;
+	sprite->pos[1] = y;
+	sprite->prev[0] = prev_x;
+	sprite->prev[1] = prev_y;
+	sprite->frame = frame;
+
+	if(x != prev_x || y != prev_y) {
+		snapshot->moving = TRUE;
+	}
+
+}
+
+static void game_remember() {
+
+	// Start of a step, whatever moves now moves away from here
+
+	memcpy(player.prev, player.pos, sizeof(vec3));
+	dash_pool_remember(&player.bullets);
+	dash_pool_remember(&enemies.pool);
+
+}
+
+static void game_update() {
+
+	int i;
+	float old_x;
+	int old_frame;
+	DashPool *bullets;
+
+	game_remember();
+
 	// Player Movement
 
-	if(player.left_down) {
+	old_x = player.pos[0];
+	old_frame = dash_anim_frame(&ship_clip, player.tick);
+
+	if(g_atomic_int_get(&player.left_down)) {
 		player.pos[0] -= player.dx;
 	}
 
-	if(player.right_down) {
+	if(g_atomic_int_get(&player.right_down)) {
 		player.pos[0] += player.dx;
 	}
 
@@ -531,58 +1170,134 @@ static gboolean on_idle(gpointer data) {
 		player.tick = player.tick_time - 1;
 	}
 
-	// Player bullet movement
-	
-	for(i = 0; i < player.num_bullets; i++) {
+	if(player.pos[0] != old_x) {
+		dirty = TRUE;
+	}
 
-		if(!player.bullets[i].active) {
-			continue;
+	if(dash_anim_frame(&ship_clip, player.tick) != old_frame) {
+		dirty = TRUE;
+	}
+
+	// Fire a bullet if the pool has room, the key handler only asks
+
+	bullets = &player.bullets;
+
+	if(g_atomic_int_compare_and_exchange(&player.fire, TRUE, FALSE)) {
+
+		i = dash_pool_spawn(bullets, player.pos[0], player.pos[1], 0.0f, player.dy);
+
+		if(i != -1) {
+			bullets->tick[i] = player.tick_time - 1;
+			dirty = TRUE;
 		}
-		
-		player.bullets[i].pos[1] += player.dy;
-		
-		if(player.bullets[i].pos[1] - player.bullet_radius > HEIGHT) {
-			
-			player.bullets[i].active = FALSE;
 
+	}
+
+	// Player bullet movement. A live bullet moves every step, and
+	// leaving the screen removes it, so either way it needs a redraw.
+
+	if(bullets->count > 0) {
+		dirty = TRUE;
+	}
+
+	dash_pool_move(bullets);
+
+	for(i = 0; i < bullets->count; i++) {
+
+		bullets->tick[i]--;
+
+		if(bullets->tick[i] < 0) {
+			bullets->tick[i] = player.tick_time - 1;
 		}
-		
-		player.bullets[i].tick = player.bullets[i].tick - 1;
 
-		if(player.bullets[i].tick < 0) {
-			player.bullets[i].tick = player.tick_time - 1;
+	}
+
+	// Backwards, so the bullet swapped into a hole was already checked
+
+	for(i = bullets->count - 1; i >= 0; i--) {
+
+		if(bullets->y[i] - player.bullet_radius > HEIGHT) {
+			dash_pool_kill(bullets, i);
 		}
 
 	}
 
 	// Enemies 
 
+	old_frame = dash_anim_frame(&enemy_small_clip, enemies.tick);
+
 	enemies.tick--;
 	if(enemies.tick < 0) {
 		enemies.tick = player.tick_time - 1;
 	}
 
-	gtk_widget_queue_draw(glArea);
-	return TRUE;
+	if(dash_anim_frame(&enemy_small_clip, enemies.tick) != old_frame) {
+		dirty = TRUE;
+	}
+
+}
+
+static void toggle_capture() {
+
+	const char *path;
+
+	// Buffers and fences belong to the widget's context
+
+	gtk_gl_area_make_current(GTK_GL_AREA(glArea));
+
+	if(recording) {
+		dash_capture_stop(&capture);
+		g_print("Captured %lu frames, dropped %lu\n", capture.frames, capture.dropped);
+		recording = FALSE;
+		return;
+	}
+
+	path = capture_path != NULL ? capture_path : "capture.y4m";
+	recording = dash_capture_start(&capture, path, (int)WIDTH, (int)HEIGHT, CAPTURE_RATE);
+	capture_next = 0;
 
 }
 
 static gint on_destroy(GtkWidget *widget) {
 
+	unsigned long issued, skipped;
+
+	dash_state_counters(&issued, &skipped);
+	g_print("GL state calls: %lu issued, %lu skipped\n", issued, skipped);
 	g_print("Widget destroyed\n");
 
 }
 
 static gboolean on_keydown(GtkWidget *widget, GdkEventKey *event) {
 
-	int i;
-
 	switch(event->keyval) {
 		case GDK_KEY_Left:
-			player.left_down = TRUE;		
+			g_atomic_int_set(&player.left_down, TRUE);
 		break;
 		case GDK_KEY_Right:
-			player.right_down = TRUE;
+			g_atomic_int_set(&player.right_down, TRUE);
+		break;
+		case GDK_KEY_o:
+			split_alpha = !split_alpha;
+			gtk_widget_queue_draw(glArea);
+		break;
+		case GDK_KEY_c:
+			toggle_capture();
+		break;
+		case GDK_KEY_r:
+
+			// Cycle nearest, linear and drawing straight to the widget
+
+			if(present_filter == GL_NEAREST) {
+				present_filter = GL_LINEAR;
+			} else if(present_filter == GL_LINEAR) {
+				present_filter = 0;
+			} else {
+				present_filter = GL_NEAREST;
+			}
+
+			gtk_widget_queue_draw(glArea);
+
 		break;
 		case GDK_KEY_space:
 
@@ -591,23 +1306,7 @@ static gboolean on_keydown(GtkWidget *widget, GdkEventKey *event) {
 			}	
 			
 			player.space_down = TRUE;
-			
-			for(i = 0; i < player.num_bullets; i++) {
-				if(player.bullets[i].active) {
-					continue;
-				}
-				
-				player.bullets[i].active = TRUE;
-
-				player.bullets[i].pos[0] = player.pos[0];
-				player.bullets[i].pos[1] = player.pos[1];
-				player.bullets[i].pos[2] = player.pos[2];
-				
-				player.bullets[i].tick = player.tick_time - 1;
-
-				break;
-
-			}
+			g_atomic_int_set(&player.fire, TRUE);
 
 		break;
 	}
@@ -618,10 +1317,10 @@ static gboolean on_keyup(GtkWidget *widget, GdkEventKey *event) {
 
 	switch(event->keyval) {
 		case GDK_KEY_Left:
-			player.left_down = FALSE;		
+			g_atomic_int_set(&player.left_down, FALSE);
 		break;
 		case GDK_KEY_Right:
-			player.right_down = FALSE;
+			g_atomic_int_set(&player.right_down, FALSE);
 		break;
 		case GDK_KEY_space:
 			player.space_down = FALSE;
@@ -0,0 +1,13 @@
+#version 130
+
+varying vec2 f_texcoord;
+uniform sampler2D mytexture;
+
+void main( void ) {
+
+	// No discard, so texels hidden by the opaque pass are rejected by
+	// the depth test before this shader runs
+
+	gl_FragColor = texture2D(mytexture, f_texcoord);
+
+}
@@ -0,0 +1,30 @@
+#version 130
+
+attribute vec2 coord2d;
+attribute vec2 texcoord;
+attribute vec4 sprite_transform;
+attribute vec2 sprite_frame;
+varying vec2 f_texcoord;
+uniform vec4 ortho;
+uniform vec4 frame_uv[64];
+uniform vec2 frame_size[64];
+
+void main(void) {
+
+	// Transform is position, scale and rotation, frame is the frame
+	// index and depth, ortho is the scale and offset of a 2D
+	// orthographic projection
+
+	int frame = int(sprite_frame.x);
+	float c = cos(sprite_transform.w);
+	float s = sin(sprite_transform.w);
+	vec2 offset = mat2(c, s, -s, c) * (coord2d * frame_size[frame] * sprite_transform.z);
+
+	gl_Position = vec4(
+		(sprite_transform.xy + offset) * ortho.xy + ortho.zw,
+		sprite_frame.y * 2.0 - 1.0,
+		1.0
+	);
+	f_texcoord = mix(frame_uv[frame].xy, frame_uv[frame].zw, texcoord);
+
+}